@@ -0,0 +1,35 @@
+#include "BatchQueue.h"
+
+using namespace std;
+
+BatchQueue::BatchQueue(int capacity) : slots(capacity), head(0), tail(0) {}
+
+bool BatchQueue::push(PrimitiveBatch *batch) {
+    size_t pushed = tail.load(memory_order_relaxed);
+    if (pushed - head.load(memory_order_acquire) == slots.size()) {
+        return false;
+    }
+    slots[pushed % slots.size()] = batch;
+    // publishes the slot together with the new count
+    tail.store(pushed + 1, memory_order_release);
+    return true;
+}
+
+bool BatchQueue::pop(PrimitiveBatch *&batch) {
+    size_t popped = head.load(memory_order_relaxed);
+    if (popped == tail.load(memory_order_acquire)) {
+        return false;
+    }
+    batch = slots[popped % slots.size()];
+    // the producer may reuse the slot once it sees the new count
+    head.store(popped + 1, memory_order_release);
+    return true;
+}
+
+bool BatchQueue::full() const {
+    return tail.load(memory_order_relaxed) - head.load(memory_order_acquire) == slots.size();
+}
+
+bool BatchQueue::empty() const {
+    return head.load(memory_order_relaxed) == tail.load(memory_order_acquire);
+}
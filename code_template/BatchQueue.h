@@ -0,0 +1,37 @@
+#ifndef __BATCH_QUEUE_H__
+#define __BATCH_QUEUE_H__
+
+#include <atomic>
+#include <vector>
+#include "PrimitiveBatch.h"
+
+using namespace std;
+
+/*
+ * Bounded lock-free ring buffer of batches between one producer and one consumer.
+ * Either side may move between threads as long as it never runs on two at once.
+ * Neither side ever blocks inside the queue: push fails when it is full and pop
+ * fails when it is empty, and the caller decides how to wait.
+ */
+class BatchQueue
+{
+public:
+    explicit BatchQueue(int capacity);
+
+    // only called by the producer
+    bool push(PrimitiveBatch *batch);
+    bool full() const;
+
+    // only called by the consumer
+    bool pop(PrimitiveBatch *&batch);
+    bool empty() const;
+
+private:
+    vector<PrimitiveBatch *> slots;
+    // total pushes and pops so far, the slot of the n-th one is n % slots.size();
+    // each lives on its own cache line so the two threads do not share one
+    alignas(64) atomic<size_t> head;
+    alignas(64) atomic<size_t> tail;
+};
+
+#endif
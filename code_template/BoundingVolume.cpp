@@ -0,0 +1,107 @@
+#include <algorithm>
+#include <cmath>
+#include "BoundingVolume.h"
+#include "Helpers.h"
+
+using namespace std;
+
+BoundingVolume::BoundingVolume() : min(0, 0, 0, -1), max(0, 0, 0, -1), center(0, 0, 0, -1) {
+    this->radius = 0;
+    this->empty = true;
+}
+
+static void centerOnBox(BoundingVolume &volume) {
+    volume.center = Vec3((volume.min.x + volume.max.x) / 2, (volume.min.y + volume.max.y) / 2,
+                         (volume.min.z + volume.max.z) / 2, -1);
+}
+
+BoundingVolume BoundingVolume::ofPoints(const VertexStream &points) {
+    BoundingVolume volume;
+    if (points.size() == 0) {
+        return volume;
+    }
+
+    volume.empty = false;
+    volume.min = Vec3(points.x[0], points.y[0], points.z[0], -1);
+    volume.max = volume.min;
+    for (size_t i = 1; i < points.size(); i++) {
+        volume.min.x = std::min(volume.min.x, points.x[i]);
+        volume.min.y = std::min(volume.min.y, points.y[i]);
+        volume.min.z = std::min(volume.min.z, points.z[i]);
+        volume.max.x = std::max(volume.max.x, points.x[i]);
+        volume.max.y = std::max(volume.max.y, points.y[i]);
+        volume.max.z = std::max(volume.max.z, points.z[i]);
+    }
+
+    centerOnBox(volume);
+    double farthest = 0;
+    for (size_t i = 0; i < points.size(); i++) {
+        double dx = points.x[i] - volume.center.x;
+        double dy = points.y[i] - volume.center.y;
+        double dz = points.z[i] - volume.center.z;
+        farthest = std::max(farthest, dx * dx + dy * dy + dz * dz);
+    }
+    volume.radius = sqrt(farthest);
+    return volume;
+}
+
+BoundingVolume BoundingVolume::transformed(const Matrix4 &m) const {
+    BoundingVolume volume;
+    if (empty) {
+        return volume;
+    }
+
+    volume.empty = false;
+    for (int corner = 0; corner < 8; corner++) {
+        Vec4 point(corner & 1 ? max.x : min.x, corner & 2 ? max.y : min.y, corner & 4 ? max.z : min.z, 1, -1);
+        point = multiplyMatrixWithVec4(m, point);
+        if (corner == 0) {
+            volume.min = Vec3(point.x, point.y, point.z, -1);
+            volume.max = volume.min;
+            continue;
+        }
+        volume.min.x = std::min(volume.min.x, point.x);
+        volume.min.y = std::min(volume.min.y, point.y);
+        volume.min.z = std::min(volume.min.z, point.z);
+        volume.max.x = std::max(volume.max.x, point.x);
+        volume.max.y = std::max(volume.max.y, point.y);
+        volume.max.z = std::max(volume.max.z, point.z);
+    }
+
+    Vec4 centerPoint = multiplyMatrixWithVec4(m, Vec4(center.x, center.y, center.z, 1, -1));
+    volume.center = Vec3(centerPoint.x, centerPoint.y, centerPoint.z, -1);
+
+    volume.radius = radius * largestScaleOfMatrix(m);
+    return volume;
+}
+
+void BoundingVolume::includeBox(const Vec3 &otherMin, const Vec3 &otherMax) {
+    if (empty) {
+        min = otherMin;
+        max = otherMax;
+        empty = false;
+    } else {
+        min.x = std::min(min.x, otherMin.x);
+        min.y = std::min(min.y, otherMin.y);
+        min.z = std::min(min.z, otherMin.z);
+        max.x = std::max(max.x, otherMax.x);
+        max.y = std::max(max.y, otherMax.y);
+        max.z = std::max(max.z, otherMax.z);
+    }
+
+    centerOnBox(*this);
+    double dx = max.x - center.x;
+    double dy = max.y - center.y;
+    double dz = max.z - center.z;
+    radius = sqrt(dx * dx + dy * dy + dz * dz);
+}
+
+void BoundingVolume::include(const BoundingVolume &other) {
+    if (!other.empty) {
+        includeBox(other.min, other.max);
+    }
+}
+
+void BoundingVolume::include(const Vec3 &point) {
+    includeBox(point, point);
+}
@@ -0,0 +1,48 @@
+#ifndef __BOUNDING_VOLUME_H__
+#define __BOUNDING_VOLUME_H__
+
+#include "Matrix4.h"
+#include "Vec3.h"
+#include "VertexStream.h"
+
+using namespace std;
+
+/*
+ * An axis aligned box and a sphere that both enclose the same set of points.
+ * The sphere is the cheaper test, the box the tighter one.
+ */
+class BoundingVolume
+{
+public:
+    Vec3 min, max;
+    Vec3 center;
+    double radius;
+    bool empty;
+
+    BoundingVolume();
+
+    /*
+     * Bounds the given points. The sphere is centered on the box and reaches the
+     * farthest point, so it is never larger than the sphere through the box corners.
+     */
+    static BoundingVolume ofPoints(const VertexStream &points);
+
+    /*
+     * Bounds of this volume after an affine transformation. The box encloses the
+     * eight transformed corners and the sphere radius grows by the largest scale
+     * of m, so the result is conservative for rotations and shears as well.
+     */
+    BoundingVolume transformed(const Matrix4 &m) const;
+
+    /*
+     * Grows the box to enclose other, or a single point. The sphere is reset
+     * to the one through the corners of the new box.
+     */
+    void include(const BoundingVolume &other);
+    void include(const Vec3 &point);
+
+private:
+    void includeBox(const Vec3 &otherMin, const Vec3 &otherMax);
+};
+
+#endif
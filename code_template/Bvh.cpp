@@ -0,0 +1,88 @@
+#include <algorithm>
+#include "Bvh.h"
+
+using namespace std;
+
+static double coordinate(const Vec3 &v, int axis) {
+    return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+}
+
+void Bvh::build(const vector<BoundingVolume> &itemBounds, int leafSize) {
+    nodes.clear();
+    items.resize(itemBounds.size());
+    for (int i = 0; i < (int) items.size(); i++) {
+        items[i] = i;
+    }
+    if (!items.empty()) {
+        buildNode(itemBounds, 0, items.size(), leafSize);
+    }
+}
+
+int Bvh::buildNode(const vector<BoundingVolume> &itemBounds, int first, int count, int leafSize) {
+    int index = nodes.size();
+    nodes.push_back(Node());
+
+    BoundingVolume bounds;
+    BoundingVolume centers;
+    for (int i = first; i < first + count; i++) {
+        const BoundingVolume &item = itemBounds[items[i]];
+        bounds.include(item);
+        centers.include(item.center);
+    }
+
+    int left = -1, right = -1;
+    if (count > leafSize) {
+        int axis = 0;
+        for (int i = 1; i < 3; i++) {
+            if (coordinate(centers.max, i) - coordinate(centers.min, i) >
+                coordinate(centers.max, axis) - coordinate(centers.min, axis)) {
+                axis = i;
+            }
+        }
+
+        int half = count / 2;
+        nth_element(items.begin() + first, items.begin() + first + half, items.begin() + first + count,
+                    [&](int a, int b) {
+                        return coordinate(itemBounds[a].center, axis) < coordinate(itemBounds[b].center, axis);
+                    });
+        left = buildNode(itemBounds, first, half, leafSize);
+        right = buildNode(itemBounds, first + half, count - half, leafSize);
+    }
+
+    // push_back in the children may have moved the node
+    Node &node = nodes[index];
+    node.bounds = bounds;
+    node.left = left;
+    node.right = right;
+    node.first = first;
+    node.count = count;
+    return index;
+}
+
+int Bvh::cull(const Frustum &frustum, vector<int> &visibleItems) const {
+    if (nodes.empty()) {
+        return 0;
+    }
+
+    int tested = 0;
+    int stack[64];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize > 0) {
+        const Node &node = nodes[stack[--stackSize]];
+        tested++;
+
+        int result = frustum.classify(node.bounds);
+        if (result == FRUSTUM_OUTSIDE) {
+            continue;
+        }
+        if (result == FRUSTUM_INSIDE || node.left < 0) {
+            visibleItems.insert(visibleItems.end(), items.begin() + node.first,
+                                items.begin() + node.first + node.count);
+            continue;
+        }
+        stack[stackSize++] = node.right;
+        stack[stackSize++] = node.left;
+    }
+    return tested;
+}
@@ -0,0 +1,46 @@
+#ifndef __BVH_H__
+#define __BVH_H__
+
+#include <vector>
+#include "BoundingVolume.h"
+#include "Frustum.h"
+
+using namespace std;
+
+/*
+ * Bounding volume hierarchy over a set of items, each given by its bounds.
+ * Items are reordered so every node covers a contiguous range of them; a node
+ * entirely inside the frustum hands over its whole range without visiting its
+ * children, so culling costs roughly in proportion to the visible items.
+ */
+class Bvh
+{
+public:
+    struct Node {
+        BoundingVolume bounds;
+        // children, -1 for leaves
+        int left, right;
+        // items of the subtree are items[first, first + count)
+        int first, count;
+    };
+
+    vector<Node> nodes; // nodes[0] is the root
+    vector<int> items;  // item ids in subtree order
+
+    /*
+     * Builds the hierarchy by splitting at the median along the longest axis of
+     * the item centers, until a node holds at most leafSize items.
+     */
+    void build(const vector<BoundingVolume> &itemBounds, int leafSize);
+
+    /*
+     * Appends the ids of the items in leaves that may be visible, in no
+     * particular order. Returns the number of nodes tested against the frustum.
+     */
+    int cull(const Frustum &frustum, vector<int> &visibleItems) const;
+
+private:
+    int buildNode(const vector<BoundingVolume> &itemBounds, int first, int count, int leafSize);
+};
+
+#endif
@@ -0,0 +1,67 @@
+#include <algorithm>
+#include <limits>
+#include "DepthBuffer.h"
+
+using namespace std;
+
+DepthBuffer::DepthBuffer() {
+    this->width = 0;
+    this->height = 0;
+    this->tilesX = 0;
+    this->tilesY = 0;
+}
+
+void DepthBuffer::reset(int width, int height) {
+    double farthest = numeric_limits<double>::infinity();
+
+    this->width = width;
+    this->height = height;
+    this->tilesX = (width + HIZ_TILE_SIZE - 1) / HIZ_TILE_SIZE;
+    this->tilesY = (height + HIZ_TILE_SIZE - 1) / HIZ_TILE_SIZE;
+
+    depth.assign((size_t) width * height, farthest);
+    tileMin.assign((size_t) tilesX * tilesY, farthest);
+    tileMax.assign((size_t) tilesX * tilesY, farthest);
+}
+
+double DepthBuffer::nearestIn(int x0, int x1, int y0, int y1) const {
+    double nearest = numeric_limits<double>::infinity();
+    for (int ty = y0 / HIZ_TILE_SIZE; ty <= y1 / HIZ_TILE_SIZE; ty++) {
+        for (int tx = x0 / HIZ_TILE_SIZE; tx <= x1 / HIZ_TILE_SIZE; tx++) {
+            nearest = min(nearest, tileMin[ty * tilesX + tx]);
+        }
+    }
+    return nearest;
+}
+
+double DepthBuffer::farthestIn(int x0, int x1, int y0, int y1) const {
+    double farthest = -numeric_limits<double>::infinity();
+    for (int ty = y0 / HIZ_TILE_SIZE; ty <= y1 / HIZ_TILE_SIZE; ty++) {
+        for (int tx = x0 / HIZ_TILE_SIZE; tx <= x1 / HIZ_TILE_SIZE; tx++) {
+            farthest = max(farthest, tileMax[ty * tilesX + tx]);
+        }
+    }
+    return farthest;
+}
+
+void DepthBuffer::updateTiles(int x0, int x1, int y0, int y1) {
+    for (int ty = y0 / HIZ_TILE_SIZE; ty <= y1 / HIZ_TILE_SIZE; ty++) {
+        int pixelY1 = min((ty + 1) * HIZ_TILE_SIZE, height);
+        for (int tx = x0 / HIZ_TILE_SIZE; tx <= x1 / HIZ_TILE_SIZE; tx++) {
+            int pixelX0 = tx * HIZ_TILE_SIZE;
+            int pixelX1 = min(pixelX0 + HIZ_TILE_SIZE, width);
+
+            double nearest = numeric_limits<double>::infinity();
+            double farthest = -numeric_limits<double>::infinity();
+            for (int y = ty * HIZ_TILE_SIZE; y < pixelY1; y++) {
+                const double *pixels = &depth[(size_t) y * width];
+                for (int x = pixelX0; x < pixelX1; x++) {
+                    nearest = min(nearest, pixels[x]);
+                    farthest = max(farthest, pixels[x]);
+                }
+            }
+            tileMin[ty * tilesX + tx] = nearest;
+            tileMax[ty * tilesX + tx] = farthest;
+        }
+    }
+}
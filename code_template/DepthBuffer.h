@@ -0,0 +1,65 @@
+#ifndef __DEPTH_BUFFER_H__
+#define __DEPTH_BUFFER_H__
+
+#include <vector>
+
+#define HIZ_TILE_SIZE 8
+
+using namespace std;
+
+/*
+ * Per pixel depth of the camera being rendered, smaller is closer. Stored
+ * row by row like the FrameBuffer, so depth(x, y) is depth[y * width + x].
+ *
+ * Next to the pixels it keeps the nearest and farthest depth of every
+ * HIZ_TILE_SIZE x HIZ_TILE_SIZE tile. The tile bounds are conservative: they
+ * are refreshed with updateTiles() after a region is drawn. In between the
+ * farthest bound only becomes loose, because stored depths only ever decrease,
+ * but the nearest one would be wrong, so every single pixel write lowers it.
+ */
+class DepthBuffer
+{
+public:
+    int width, height;
+    int tilesX, tilesY;
+    vector<double> depth;
+    vector<double> tileMin;
+    vector<double> tileMax;
+
+    DepthBuffer();
+
+    /*
+     * Resizes the buffer if needed and clears every pixel to infinitely far.
+     */
+    void reset(int width, int height);
+
+    double *row(int y) {
+        return &depth[(size_t) y * width];
+    }
+
+    bool testAndSet(int x, int y, double z) {
+        double &stored = depth[(size_t) y * width + x];
+        if (z < stored) {
+            stored = z;
+            double &nearest = tileMin[(y / HIZ_TILE_SIZE) * tilesX + x / HIZ_TILE_SIZE];
+            if (z < nearest) {
+                nearest = z;
+            }
+            return true;
+        }
+        return false;
+    }
+
+    /*
+     * Nearest and farthest stored depth over the tiles overlapping [x0, x1] x [y0, y1].
+     */
+    double nearestIn(int x0, int x1, int y0, int y1) const;
+    double farthestIn(int x0, int x1, int y0, int y1) const;
+
+    /*
+     * Recomputes the bounds of the tiles overlapping [x0, x1] x [y0, y1] from their pixels.
+     */
+    void updateTiles(int x0, int x1, int y0, int y1);
+};
+
+#endif
@@ -0,0 +1,70 @@
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+#include "FrameBuffer.h"
+
+using namespace std;
+
+FrameBuffer::FrameBuffer() {
+    this->width = 0;
+    this->height = 0;
+    this->format = FRAMEBUFFER_RGBA8;
+    this->stride = 0;
+    this->data = NULL;
+    this->capacity = 0;
+}
+
+FrameBuffer::~FrameBuffer() {
+    free(data);
+}
+
+size_t FrameBuffer::pixelSize(int format) {
+    if (format == FRAMEBUFFER_RGBA8) {
+        return sizeof(PixelRGBA8);
+    }
+    return format == FRAMEBUFFER_FLOAT_RGB ? sizeof(PixelFloatRGB) : sizeof(PixelPacked);
+}
+
+void FrameBuffer::reset(int width, int height, int format) {
+    this->width = width;
+    this->height = height;
+    this->format = format;
+
+    size_t rowBytes = width * pixelSize(format);
+    this->stride = (rowBytes + FRAMEBUFFER_ALIGNMENT - 1) / FRAMEBUFFER_ALIGNMENT * FRAMEBUFFER_ALIGNMENT;
+
+    size_t size = stride * height;
+    if (size > capacity) {
+        free(data);
+        data = (unsigned char *) aligned_alloc(FRAMEBUFFER_ALIGNMENT, size);
+        if (data == NULL) {
+            throw bad_alloc();
+        }
+        capacity = size;
+    }
+}
+
+void FrameBuffer::clear(const Color &color) {
+    // fill the first row, then copy it to the others
+    for (int x = 0; x < width; x++) {
+        setPixel(x, 0, color);
+    }
+    size_t rowBytes = width * pixelSize(format);
+    for (int y = 1; y < height; y++) {
+        copy(data, data + rowBytes, data + y * stride);
+    }
+}
+
+Color FrameBuffer::getPixel(int x, int y) const {
+    const unsigned char *rowData = data + y * stride;
+    if (format == FRAMEBUFFER_RGBA8) {
+        const PixelRGBA8 &pixel = ((const PixelRGBA8 *) rowData)[x];
+        return Color(pixel.r, pixel.g, pixel.b);
+    }
+    if (format == FRAMEBUFFER_FLOAT_RGB) {
+        const PixelFloatRGB &pixel = ((const PixelFloatRGB *) rowData)[x];
+        return Color(pixel.r, pixel.g, pixel.b);
+    }
+    unsigned long long word = ((const PixelPacked *) rowData)[x].word.load(memory_order_relaxed);
+    return Color((word >> 16) & 0xFF, (word >> 8) & 0xFF, word & 0xFF);
+}
@@ -0,0 +1,150 @@
+#ifndef __FRAME_BUFFER_H__
+#define __FRAME_BUFFER_H__
+
+#include <atomic>
+#include <cstddef>
+#include "Color.h"
+
+// pixel storage formats
+#define FRAMEBUFFER_RGBA8 0     // 8 bits per channel, clamped and truncated like the PPM output
+#define FRAMEBUFFER_FLOAT_RGB 1 // one float per channel, unclamped
+#define FRAMEBUFFER_PACKED 2    // depth and 8 bit color in one word, safe to draw into from many threads
+
+// quantized depth of packed pixels nothing was drawn to, drawn pixels are always nearer
+#define PACKED_DEPTH_FAR 0xFFFFFFFFULL
+
+// rows start on cache line boundaries
+#define FRAMEBUFFER_ALIGNMENT 64
+
+using namespace std;
+
+struct PixelRGBA8 {
+    unsigned char r, g, b, a;
+};
+
+struct PixelFloatRGB {
+    float r, g, b;
+};
+
+/*
+ * Quantized depth in the upper 32 bits and the 8 bit channels in the lower ones,
+ * so the smaller of two words is the nearer sample.
+ */
+struct PixelPacked {
+    atomic<unsigned long long> word;
+};
+
+/*
+ * Converts a channel to 8 bits the same way Scene::makeBetweenZeroAnd255 does,
+ * so storing RGBA8 gives exactly the values written to the PPM file.
+ */
+inline unsigned char toChannel8(double value) {
+    if (value >= 255.0)
+        return 255;
+    if (value <= 0.0)
+        return 0;
+    return (unsigned char) (int) value;
+}
+
+inline void storeColor(PixelRGBA8 &pixel, const Color &color) {
+    pixel.r = toChannel8(color.r);
+    pixel.g = toChannel8(color.g);
+    pixel.b = toChannel8(color.b);
+    pixel.a = 255;
+}
+
+inline void storeColor(PixelFloatRGB &pixel, const Color &color) {
+    pixel.r = (float) color.r;
+    pixel.g = (float) color.g;
+    pixel.b = (float) color.b;
+}
+
+/*
+ * Maps a viewport depth in [0, 1] to [0, PACKED_DEPTH_FAR), keeping its order.
+ * Depths closer than one part in 2^32 become equal.
+ */
+inline unsigned long long quantizeDepth(double depth) {
+    if (depth <= 0.0)
+        return 0;
+    if (depth >= 1.0)
+        return PACKED_DEPTH_FAR - 1;
+    return (unsigned long long) (depth * (double) (PACKED_DEPTH_FAR - 1));
+}
+
+inline unsigned long long packPixel(unsigned long long quantizedDepth, const Color &color) {
+    return quantizedDepth << 32 | (unsigned long long) toChannel8(color.r) << 16 |
+           (unsigned long long) toChannel8(color.g) << 8 | toChannel8(color.b);
+}
+
+// stores the color without a depth, later writes win, so only one thread may draw a pixel this way
+inline void storeColor(PixelPacked &pixel, const Color &color) {
+    pixel.word.store(packPixel(PACKED_DEPTH_FAR, color), memory_order_relaxed);
+}
+
+/*
+ * Keeps the nearer of the stored sample and the given one. Any number of threads
+ * may do this on the same pixel at once; the result does not depend on their order.
+ * Samples of equal quantized depth keep the smaller packed color.
+ */
+inline void storeNearest(PixelPacked &pixel, const Color &color, double depth) {
+    unsigned long long word = packPixel(quantizeDepth(depth), color);
+    unsigned long long stored = pixel.word.load(memory_order_relaxed);
+    while (word < stored && !pixel.word.compare_exchange_weak(stored, word, memory_order_relaxed)) {
+    }
+}
+
+/*
+ * Color image of the camera being rendered, in one contiguous row-major
+ * allocation: pixel (x, y) is element x of row(y). y grows upwards like the
+ * viewport, the PPM writer flips it.
+ */
+class FrameBuffer
+{
+public:
+    int width, height;
+    int format;
+    size_t stride; // bytes from one row to the next, a multiple of FRAMEBUFFER_ALIGNMENT
+
+    FrameBuffer();
+    ~FrameBuffer();
+
+    /*
+     * Resizes the buffer if needed. The pixels are left undefined until clear().
+     */
+    void reset(int width, int height, int format);
+
+    void clear(const Color &color);
+
+    template<typename Pixel>
+    Pixel *row(int y) {
+        return (Pixel *) (data + y * stride);
+    }
+
+    void setPixel(int x, int y, const Color &color) {
+        if (format == FRAMEBUFFER_RGBA8) {
+            storeColor(row<PixelRGBA8>(y)[x], color);
+        } else if (format == FRAMEBUFFER_FLOAT_RGB) {
+            storeColor(row<PixelFloatRGB>(y)[x], color);
+        } else {
+            storeColor(row<PixelPacked>(y)[x], color);
+        }
+    }
+
+    // depth tested write of a FRAMEBUFFER_PACKED pixel, see storeNearest
+    void setPixelIfNearer(int x, int y, const Color &color, double depth) {
+        storeNearest(row<PixelPacked>(y)[x], color, depth);
+    }
+
+    Color getPixel(int x, int y) const;
+
+    static size_t pixelSize(int format);
+
+private:
+    unsigned char *data;
+    size_t capacity;
+
+    FrameBuffer(const FrameBuffer &other);
+    FrameBuffer &operator=(const FrameBuffer &other);
+};
+
+#endif
@@ -0,0 +1,58 @@
+#include <cmath>
+#include "Frustum.h"
+
+using namespace std;
+
+Frustum::Frustum(const Matrix4 &viewProjectionMatrix) {
+    // a point is inside when -w <= x, y, z <= w in clip space; each of those
+    // inequalities is row 3 plus or minus another row of the matrix
+    const double (*m)[4] = viewProjectionMatrix.val;
+    for (int axis = 0; axis < 3; axis++) {
+        for (int col = 0; col < 4; col++) {
+            planes[axis * 2][col] = m[3][col] + m[axis][col];
+            planes[axis * 2 + 1][col] = m[3][col] - m[axis][col];
+        }
+    }
+}
+
+int Frustum::classify(const BoundingVolume &volume) const {
+    if (volume.empty) {
+        return FRUSTUM_OUTSIDE;
+    }
+
+    bool sphereInside = true;
+    for (int i = 0; i < FRUSTUM_PLANE_COUNT; i++) {
+        const double *p = planes[i];
+        double distance = p[0] * volume.center.x + p[1] * volume.center.y + p[2] * volume.center.z + p[3];
+        double reach = volume.radius * sqrt(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+        if (distance < -reach) {
+            return FRUSTUM_OUTSIDE;
+        }
+        if (distance < reach) {
+            sphereInside = false;
+        }
+    }
+    if (sphereInside) {
+        return FRUSTUM_INSIDE;
+    }
+
+    // the box is outside a plane when even its corner farthest along the plane normal is,
+    // and inside all of them when even the nearest corner is inside every plane
+    bool boxInside = true;
+    for (int i = 0; i < FRUSTUM_PLANE_COUNT; i++) {
+        const double *p = planes[i];
+        double farX = p[0] > 0 ? volume.max.x : volume.min.x;
+        double farY = p[1] > 0 ? volume.max.y : volume.min.y;
+        double farZ = p[2] > 0 ? volume.max.z : volume.min.z;
+        if (p[0] * farX + p[1] * farY + p[2] * farZ + p[3] < 0) {
+            return FRUSTUM_OUTSIDE;
+        }
+        double nearX = p[0] > 0 ? volume.min.x : volume.max.x;
+        double nearY = p[1] > 0 ? volume.min.y : volume.max.y;
+        double nearZ = p[2] > 0 ? volume.min.z : volume.max.z;
+        if (p[0] * nearX + p[1] * nearY + p[2] * nearZ + p[3] < 0) {
+            boxInside = false;
+        }
+    }
+    return boxInside ? FRUSTUM_INSIDE : FRUSTUM_INTERSECTS;
+}
@@ -0,0 +1,37 @@
+#ifndef __FRUSTUM_H__
+#define __FRUSTUM_H__
+
+#include "BoundingVolume.h"
+#include "Matrix4.h"
+
+#define FRUSTUM_PLANE_COUNT 6
+
+#define FRUSTUM_OUTSIDE 0
+#define FRUSTUM_INSIDE 1
+#define FRUSTUM_INTERSECTS 2
+
+using namespace std;
+
+/*
+ * The view volume of a camera as six planes in world space. They are read off
+ * the view-projection matrix, so they describe exactly the box given by the
+ * camera's left, right, bottom, top, near and far for both projection types.
+ */
+class Frustum
+{
+public:
+    // plane i keeps the points where planes[i] . (x, y, z, 1) >= 0
+    double planes[FRUSTUM_PLANE_COUNT][4];
+
+    Frustum(const Matrix4 &viewProjectionMatrix);
+
+    /*
+     * Returns FRUSTUM_OUTSIDE if the volume is certainly outside the frustum,
+     * FRUSTUM_INSIDE if it is certainly inside and FRUSTUM_INTERSECTS otherwise.
+     * Tries the sphere first and the box only when the sphere straddles a plane.
+     * Volumes near an edge of the frustum may be reported as intersecting.
+     */
+    int classify(const BoundingVolume &volume) const;
+};
+
+#endif
@@ -160,7 +160,7 @@ Matrix4 getIdentityMatrix()
 /*
  * Multiply matrices m1 (Matrix4) and m2 (Matrix4) and return the result matrix r (Matrix4).
  */
-Matrix4 multiplyMatrixWithMatrix(Matrix4 m1, Matrix4 m2)
+Matrix4 multiplyMatrixWithMatrix(const Matrix4 &m1, const Matrix4 &m2)
 {
     Matrix4 result;
     double total;
@@ -185,8 +185,9 @@ Matrix4 multiplyMatrixWithMatrix(Matrix4 m1, Matrix4 m2)
 /*
  * Multiply matrix m (Matrix4) with vector v (vec4) and store the result in vector r (vec4).
  */
-Vec4 multiplyMatrixWithVec4(Matrix4 m, Vec4 v)
+Vec4 multiplyMatrixWithVec4(const Matrix4 &m, const Vec4 &v)
 {
+    double elements[4] = {v.x, v.y, v.z, v.t};
     double values[4];
     double total;
 
@@ -195,10 +196,51 @@ Vec4 multiplyMatrixWithVec4(Matrix4 m, Vec4 v)
         total = 0;
         for (int j = 0; j < 4; j++)
         {
-            total += m.val[i][j] * v.getElementAt(j);
+            total += m.val[i][j] * elements[j];
         }
         values[i] = total;
     }
 
     return Vec4(values[0], values[1], values[2], values[3], v.colorId);
+}
+
+/*
+ * Largest factor the upper left 3x3 part of m stretches any direction by.
+ */
+double largestScaleOfMatrix(const Matrix4 &m)
+{
+    // the square root of the largest eigenvalue of b = a^T a, found in closed form
+    double b[3][3];
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            b[i][j] = m.val[0][i] * m.val[0][j] + m.val[1][i] * m.val[1][j] + m.val[2][i] * m.val[2][j];
+        }
+    }
+
+    double offDiagonal = b[0][1] * b[0][1] + b[0][2] * b[0][2] + b[1][2] * b[1][2];
+    double q = (b[0][0] + b[1][1] + b[2][2]) / 3;
+    double p = sqrt(((b[0][0] - q) * (b[0][0] - q) + (b[1][1] - q) * (b[1][1] - q) +
+                     (b[2][2] - q) * (b[2][2] - q) + 2 * offDiagonal) / 6);
+    double largest = q;
+    if (p > 0)
+    {
+        double c[3][3];
+        for (int i = 0; i < 3; i++)
+        {
+            for (int j = 0; j < 3; j++)
+            {
+                c[i][j] = (b[i][j] - (i == j ? q : 0)) / p;
+            }
+        }
+        double r = (c[0][0] * (c[1][1] * c[2][2] - c[1][2] * c[2][1]) -
+                    c[0][1] * (c[1][0] * c[2][2] - c[1][2] * c[2][0]) +
+                    c[0][2] * (c[1][0] * c[2][1] - c[1][1] * c[2][0])) / 2;
+        r = r < -1 ? -1 : (r > 1 ? 1 : r);
+        largest = q + 2 * p * cos(acos(r) / 3);
+    }
+
+    // a little extra so rounding never makes bounds built from it too small
+    return sqrt(largest) * (1 + 1e-9);
 }
\ No newline at end of file
@@ -0,0 +1,216 @@
+#include <algorithm>
+#include <iomanip>
+#include "JobSystem.h"
+
+// failed attempts to find work before an idle worker goes to sleep
+#define JOB_SPIN_COUNT 64
+
+using namespace std;
+
+// the system and worker index of the calling thread
+static thread_local JobSystem *ownerSystem = NULL;
+static thread_local int ownerIndex = -1;
+
+static long long nanosecondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+}
+
+JobSystem::Worker::Worker() : indicesRun(0), tasksStolen(0), idleNanoseconds(0) {}
+
+JobSystem::JobSystem(int threadCount) : queuedTasks(0), sleepingWorkers(0), stopping(false) {
+    threadCount = max(threadCount, 1);
+    for (int i = 0; i < threadCount; i++) {
+        workers.emplace_back(new Worker());
+    }
+    ownerSystem = this;
+    ownerIndex = 0;
+    statsStart = chrono::steady_clock::now();
+
+    for (int i = 1; i < threadCount; i++) {
+        threads.emplace_back(&JobSystem::workerLoop, this, i);
+    }
+}
+
+JobSystem::~JobSystem() {
+    {
+        unique_lock<mutex> guard(sleepLock);
+        stopping = true;
+    }
+    wakeUp.notify_all();
+    for (auto &worker: threads) {
+        worker.join();
+    }
+    if (ownerSystem == this) {
+        ownerSystem = NULL;
+        ownerIndex = -1;
+    }
+}
+
+int JobSystem::size() const {
+    return workers.size();
+}
+
+int JobSystem::currentWorker() const {
+    return ownerSystem == this ? ownerIndex : -1;
+}
+
+void JobSystem::parallelFor(int count, const function<void(int)> &job, int grain) {
+    int worker = currentWorker();
+    grain = max(grain, 1);
+    if (count <= 0) {
+        return;
+    }
+    if (threads.empty() || worker < 0 || count <= grain) {
+        for (int i = 0; i < count; i++) {
+            job(i);
+        }
+        if (worker >= 0) {
+            workers[worker]->indicesRun += count;
+        }
+        return;
+    }
+
+    atomic<int> remaining(count);
+    Task task = {&job, 0, count, grain, &remaining};
+    run(worker, task);
+
+    // help with whatever is queued, this loop or any other, until every index of this loop has run
+    while (remaining.load(memory_order_acquire) > 0) {
+        if (!runOne(worker)) {
+            auto start = chrono::steady_clock::now();
+            this_thread::yield();
+            workers[worker]->idleNanoseconds += nanosecondsSince(start);
+        }
+    }
+}
+
+void JobSystem::spawn(const function<void(int)> &job, int index, atomic<int> &remaining) {
+    int worker = currentWorker();
+    if (worker < 0) {
+        job(index);
+        remaining.fetch_sub(1, memory_order_release);
+        return;
+    }
+    Task task = {&job, index, index + 1, 1, &remaining};
+    push(worker, task);
+}
+
+bool JobSystem::helpOnce() {
+    int worker = currentWorker();
+    return worker >= 0 && runOne(worker);
+}
+
+void JobSystem::push(int worker, const Task &task) {
+    {
+        unique_lock<mutex> guard(workers[worker]->lock);
+        workers[worker]->tasks.push_back(task);
+        queuedTasks++;
+    }
+    // a worker going to sleep counts itself before it checks queuedTasks, so one of the two sides sees the other
+    if (sleepingWorkers > 0) {
+        unique_lock<mutex> guard(sleepLock);
+        wakeUp.notify_one();
+    }
+}
+
+bool JobSystem::take(int worker, Task &task) {
+    if (queuedTasks == 0) {
+        return false;
+    }
+
+    Worker &own = *workers[worker];
+    {
+        unique_lock<mutex> guard(own.lock);
+        if (!own.tasks.empty()) {
+            task = own.tasks.back();
+            own.tasks.pop_back();
+            queuedTasks--;
+            return true;
+        }
+    }
+
+    int count = workers.size();
+    for (int i = 1; i < count; i++) {
+        Worker &victim = *workers[(worker + i) % count];
+        unique_lock<mutex> guard(victim.lock);
+        if (!victim.tasks.empty()) {
+            task = victim.tasks.front();
+            victim.tasks.pop_front();
+            queuedTasks--;
+            own.tasksStolen++;
+            return true;
+        }
+    }
+    return false;
+}
+
+void JobSystem::run(int worker, Task task) {
+    // keep the lower half and leave the upper one for this worker later or for a thief
+    while (task.last - task.first > task.grain) {
+        Task upper = task;
+        upper.first = task.first + (task.last - task.first) / 2;
+        task.last = upper.first;
+        push(worker, upper);
+    }
+
+    for (int i = task.first; i < task.last; i++) {
+        (*task.job)(i);
+    }
+    workers[worker]->indicesRun += task.last - task.first;
+    // the loop may return as soon as this reaches 0, so task is not touched afterwards
+    task.remaining->fetch_sub(task.last - task.first, memory_order_release);
+}
+
+bool JobSystem::runOne(int worker) {
+    Task task;
+    if (!take(worker, task)) {
+        return false;
+    }
+    run(worker, task);
+    return true;
+}
+
+void JobSystem::workerLoop(int index) {
+    ownerSystem = this;
+    ownerIndex = index;
+
+    int misses = 0;
+    while (!stopping) {
+        if (runOne(index)) {
+            misses = 0;
+            continue;
+        }
+
+        auto start = chrono::steady_clock::now();
+        if (++misses < JOB_SPIN_COUNT) {
+            this_thread::yield();
+        } else {
+            unique_lock<mutex> guard(sleepLock);
+            sleepingWorkers++;
+            wakeUp.wait(guard, [this] { return stopping || queuedTasks > 0; });
+            sleepingWorkers--;
+            misses = 0;
+        }
+        workers[index]->idleNanoseconds += nanosecondsSince(start);
+    }
+}
+
+void JobSystem::resetStats() {
+    for (auto &worker: workers) {
+        worker->indicesRun = 0;
+        worker->tasksStolen = 0;
+        worker->idleNanoseconds = 0;
+    }
+    statsStart = chrono::steady_clock::now();
+}
+
+void JobSystem::printStats(ostream &os) const {
+    long long elapsed = max(nanosecondsSince(statsStart), 1LL);
+    os << "Workers:" << endl << fixed << setprecision(1);
+    for (int i = 0; i < size(); i++) {
+        const Worker &worker = *workers[i];
+        double busy = 100.0 * max(elapsed - worker.idleNanoseconds.load(), 0LL) / elapsed;
+        os << "\tworker " << i << ": " << busy << "% busy, " << worker.indicesRun << " jobs, "
+           << worker.tasksStolen << " stolen" << endl;
+    }
+}
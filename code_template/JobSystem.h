@@ -0,0 +1,101 @@
+#ifndef __JOB_SYSTEM_H__
+#define __JOB_SYSTEM_H__
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+/*
+ * Work-stealing scheduler shared by every stage of the pipeline. Each worker
+ * keeps its own deque of index ranges: it splits and runs them from the back,
+ * idle workers steal from the front, where the largest ranges are. The thread
+ * that creates the system is worker 0 and takes part whenever it waits on a
+ * loop, so a system of size 1 has no threads of its own and runs loops inline.
+ */
+class JobSystem
+{
+public:
+    explicit JobSystem(int threadCount);
+    ~JobSystem();
+
+    int size() const;
+
+    /*
+     * Runs job(i) for every i in [0, count) and returns after all of them are done.
+     * Ranges are split in halves until they hold at most grain indices. Jobs may
+     * start loops of their own; a waiting worker runs other queued jobs meanwhile,
+     * so nested loops are balanced over all workers. Jobs must not depend on each other.
+     */
+    void parallelFor(int count, const function<void(int)> &job, int grain = 1);
+
+    /*
+     * Queues job(index) to run on any worker and returns at once. remaining is decremented
+     * after the job has returned, and the caller must keep job alive until then. Called from
+     * a thread that is not a worker, it runs the job before returning.
+     */
+    void spawn(const function<void(int)> &job, int index, atomic<int> &remaining);
+
+    /*
+     * Runs one queued job of any loop or spawn on the calling worker. Returns false if there
+     * was none or the caller is not a worker, so a thread waiting on spawned jobs can help.
+     */
+    bool helpOnce();
+
+    // starts a new utilization measurement period
+    void resetStats();
+
+    // per worker utilization since the last resetStats, printed with -stats
+    void printStats(ostream &os) const;
+
+private:
+    struct Task {
+        const function<void(int)> *job;
+        int first, last, grain;
+        // indices of the loop not finished yet, the loop is done when it reaches 0
+        atomic<int> *remaining;
+    };
+
+    struct Worker {
+        mutex lock;
+        deque<Task> tasks;
+        atomic<long long> indicesRun;
+        atomic<long long> tasksStolen;
+        // time spent looking for work without finding any, or sleeping
+        atomic<long long> idleNanoseconds;
+
+        Worker();
+    };
+
+    vector<unique_ptr<Worker>> workers;
+    vector<thread> threads;
+    chrono::steady_clock::time_point statsStart;
+
+    // tasks sitting in any deque; idle workers sleep while there are none
+    atomic<int> queuedTasks;
+    atomic<int> sleepingWorkers;
+    mutex sleepLock;
+    condition_variable wakeUp;
+    atomic<bool> stopping;
+
+    // index of the calling thread among the workers, -1 for threads of other systems
+    int currentWorker() const;
+
+    void push(int worker, const Task &task);
+    // takes a task from the back of the worker's own deque, or steals from the front of another one
+    bool take(int worker, Task &task);
+    void run(int worker, Task task);
+    // runs one queued task if there is any, measuring the time it spends looking as idle
+    bool runOne(int worker);
+    void workerLoop(int index);
+};
+
+#endif
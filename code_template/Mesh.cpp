@@ -1,4 +1,8 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <vector>
+#include "Helpers.h"
 #include "Triangle.h"
 #include "Mesh.h"
 #include <iostream>
@@ -6,22 +10,68 @@
 
 using namespace std;
 
-Mesh::Mesh() {}
+Mesh::Mesh() : geometry(NULL), worldGeometryVersion(-1), worldScale(1) {}
 
 Mesh::Mesh(int meshId, int type, int numberOfTransformations,
              vector<int> transformationIds,
              vector<char> transformationTypes,
-             int numberOfTriangles,
-             vector<Triangle> triangles)
+             MeshGeometry *geometry)
 {
+    this->worldGeometryVersion = -1;
+    this->worldScale = 1;
     this->meshId = meshId;
     this->type = type;
     this->numberOfTransformations = numberOfTransformations;
-    this->numberOfTriangles = numberOfTriangles;
+    this->numberOfTriangles = geometry->triangles.size();
 
     this->transformationIds = transformationIds;
     this->transformationTypes = transformationTypes;
-    this->triangles = triangles;
+    this->geometry = geometry;
+}
+
+int Mesh::selectLevel(const Camera &camera, double maxPixelError) const
+{
+    const vector<MeshLevel> &levels = geometry->levels;
+    // wireframe meshes always show every edge
+    if (levels.size() == 1 || maxPixelError <= 0 || type == WIREFRAME) {
+        return 0;
+    }
+
+    double pixelsPerUnit = max(camera.horRes / (camera.right - camera.left), camera.verRes / (camera.top - camera.bottom));
+    if (camera.projectionType == PROJ_PERSPECTIVE) {
+        // the image plane is at the near distance, things farther away shrink in proportion
+        double depth = dotProductVec3(subtractVec3(worldBounds.center, camera.pos), camera.gaze) - worldBounds.radius;
+        pixelsPerUnit *= camera.near / max(depth, camera.near);
+    }
+
+    for (int i = levels.size() - 1; i > 0; i--) {
+        if (levels[i].error * worldScale * pixelsPerUnit <= maxPixelError) {
+            return i;
+        }
+    }
+    return 0;
+}
+
+bool Mesh::updateWorldVertices(const Matrix4 &modelingMatrix)
+{
+    if (worldGeometryVersion == geometry->version &&
+        memcmp(this->modelingMatrix.val, modelingMatrix.val, sizeof(modelingMatrix.val)) == 0) {
+        return false;
+    }
+
+    this->modelingMatrix = modelingMatrix;
+    transformPoints(modelingMatrix, geometry->objectVertices, worldVertices);
+    worldBounds = geometry->objectBounds.transformed(modelingMatrix);
+    worldScale = largestScaleOfMatrix(modelingMatrix);
+
+    int levelCount = geometry->levels.size();
+    levelMeshlets.resize(levelCount);
+    levelHierarchies.resize(levelCount);
+    for (int i = 0; i < levelCount; i++) {
+        geometry->levels[i].updateMeshlets(worldVertices, levelMeshlets[i], levelHierarchies[i]);
+    }
+    worldGeometryVersion = geometry->version;
+    return true;
 }
 
 ostream &operator<<(ostream &os, const Mesh &m)
@@ -40,8 +90,9 @@ ostream &operator<<(ostream &os, const Mesh &m)
     os << fixed << setprecision(3) << m.numberOfTransformations << " transformations and " << m.numberOfTriangles << " triangles"
        << endl << "\tTriangles are:" << endl << fixed << setprecision(0);
 
-    for (int i = 0; i < m.triangles.size(); i++) {
-        os << "\t\t" << m.triangles[i].vertexIds[0] << " " << m.triangles[i].vertexIds[1] << " " << m.triangles[i].vertexIds[2] << endl;
+    const vector<Triangle> &triangles = m.geometry->triangles;
+    for (int i = 0; i < triangles.size(); i++) {
+        os << "\t\t" << triangles[i].vertexIds[0] << " " << triangles[i].vertexIds[1] << " " << triangles[i].vertexIds[2] << endl;
     }
 
     return os;
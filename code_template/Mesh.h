@@ -2,7 +2,13 @@
 #define __MESH_H__
 
 #include <vector>
-#include "Triangle.h"
+#include "BoundingVolume.h"
+#include "Bvh.h"
+#include "Camera.h"
+#include "MeshGeometry.h"
+#include "Meshlet.h"
+#include "Matrix4.h"
+#include "VertexStream.h"
 #include <iostream>
 
 #define WIREFRAME 0
@@ -20,17 +26,45 @@ public:
     vector<int> transformationIds;
     vector<char> transformationTypes;
     int numberOfTriangles;
-    vector <Triangle> triangles;
+    // faces and object space vertices, possibly shared with other instances of the same object
+    MeshGeometry *geometry;
+
+    // product of the mesh transformations, from object to world space
+    Matrix4 modelingMatrix;
+    // geometry->objectVertices transformed by modelingMatrix, shared by every camera
+    VertexStream worldVertices;
+    // geometry->version the world space data was built from, -1 before the first time
+    int worldGeometryVersion;
+    // bounds of the geometry carried to world space by modelingMatrix
+    BoundingVolume worldBounds;
+    // largest factor modelingMatrix stretches any direction by
+    double worldScale;
+    // per level of the geometry: its meshlets with world space bounds and cones, and the hierarchy over them
+    vector<vector<Meshlet>> levelMeshlets;
+    vector<Bvh> levelHierarchies;
 
     Mesh();
 
     Mesh(int meshId, int type, int numberOfTransformations,
          vector<int> transformationIds,
          vector<char> transformationTypes,
-         int numberOfTriangles,
-         vector <Triangle> triangles);
+         MeshGeometry *geometry);
+
+    /*
+     * Returns the coarsest level whose error, projected to the image of the camera
+     * at the nearest point of worldBounds, is at most maxPixelError pixels.
+     */
+    int selectLevel(const Camera &camera, double maxPixelError) const;
+
+    /*
+     * Brings worldVertices, worldBounds and the meshlets of every level up to date
+     * for the given modeling matrix. They are only recomputed when the matrix differs
+     * from the one they were built with or the geometry changed since.
+     * Returns true if they were recomputed.
+     */
+    bool updateWorldVertices(const Matrix4 &modelingMatrix);
 
     friend ostream &operator<<(ostream &os, const Mesh &m);
 };
 
-#endif
\ No newline at end of file
+#endif
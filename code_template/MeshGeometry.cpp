@@ -0,0 +1,77 @@
+#include <unordered_map>
+#include <vector>
+#include "MeshGeometry.h"
+#include "MeshSimplifier.h"
+
+using namespace std;
+
+MeshGeometry::MeshGeometry()
+{
+    this->version = 0;
+}
+
+void MeshGeometry::indexVertices(const VertexStream &sceneVertices)
+{
+    unordered_map<int, int> indexOfVertexId;
+    vertexIds.clear();
+    objectVertices.clear();
+    version++;
+
+    for (auto &triangle: triangles) {
+        for (int i = 0; i < 3; i++) {
+            auto found = indexOfVertexId.find(triangle.vertexIds[i]);
+            if (found == indexOfVertexId.end()) {
+                found = indexOfVertexId.emplace(triangle.vertexIds[i], (int) vertexIds.size()).first;
+                vertexIds.push_back(triangle.vertexIds[i]);
+
+                int sceneIndex = triangle.vertexIds[i] - 1;
+                objectVertices.addPoint(sceneVertices.x[sceneIndex], sceneVertices.y[sceneIndex],
+                                        sceneVertices.z[sceneIndex], sceneVertices.colorIds[sceneIndex]);
+            }
+            triangle.vertexIndices[i] = found->second;
+        }
+    }
+    objectBounds = BoundingVolume::ofPoints(objectVertices);
+
+    levels.assign(1, MeshLevel());
+    levels[0].triangles = triangles;
+    levels[0].buildMeshlets(objectVertices);
+}
+
+void MeshGeometry::buildLevels()
+{
+    clearLevels();
+    int targetCount = triangles.size() / 2;
+    if (targetCount < MESH_LOD_MIN_TRIANGLES) {
+        return;
+    }
+
+    MeshSimplifier simplifier(objectVertices, triangles);
+    while (levels.size() <= MESH_LOD_MAX_LEVELS && targetCount >= MESH_LOD_MIN_TRIANGLES) {
+        MeshLevel level;
+        level.triangles = simplifier.simplify(targetCount);
+        // collapses ran out well before the target, the mesh cannot get much simpler
+        if (level.triangles.size() > levels.back().triangles.size() * 3 / 4) {
+            break;
+        }
+
+        level.error = simplifier.error;
+        for (auto &triangle: level.triangles) {
+            for (int i = 0; i < 3; i++) {
+                triangle.vertexIds[i] = vertexIds[triangle.vertexIndices[i]];
+            }
+        }
+        level.buildMeshlets(objectVertices);
+        levels.push_back(level);
+        version++;
+        targetCount = level.triangles.size() / 2;
+    }
+}
+
+void MeshGeometry::clearLevels()
+{
+    if (levels.size() > 1) {
+        levels.resize(1);
+        version++;
+    }
+}
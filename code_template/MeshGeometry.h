@@ -0,0 +1,55 @@
+#ifndef __MESH_GEOMETRY_H__
+#define __MESH_GEOMETRY_H__
+
+#include <vector>
+#include "BoundingVolume.h"
+#include "MeshLevel.h"
+#include "Triangle.h"
+#include "VertexStream.h"
+
+// simplified levels built per geometry; each has about half the triangles of the one before
+#define MESH_LOD_MAX_LEVELS 4
+// geometries are not simplified below this many triangles
+#define MESH_LOD_MIN_TRIANGLES 128
+
+using namespace std;
+
+/*
+ * The object space part of a mesh: its faces, their vertices and everything
+ * derived from them alone. Instances of the same object share one geometry and
+ * only keep their own transformations and world space data.
+ */
+class MeshGeometry
+{
+public:
+    vector<Triangle> triangles;
+    // scene vertex ids used by the triangles, each listed once; triangles refer to them through vertexIndices
+    vector<int> vertexIds;
+    // object space positions of vertexIds, in the same order
+    VertexStream objectVertices;
+    BoundingVolume objectBounds;
+    // levels[0] holds all of triangles, the others are simplified versions of it
+    vector<MeshLevel> levels;
+    // bumped whenever the data above changes, so instances know to refresh their world space data
+    int version;
+
+    MeshGeometry();
+
+    /*
+     * Builds vertexIds, objectVertices, objectBounds and levels[0] and fills vertexIndices of
+     * every triangle, so shared vertices are transformed once instead of once per triangle.
+     * Call it again after changing the scene vertices; that also drops the simplified levels.
+     */
+    void indexVertices(const VertexStream &sceneVertices);
+
+    /*
+     * Adds simplified levels by quadric error edge collapse, halving the triangle
+     * count each time, down to MESH_LOD_MIN_TRIANGLES.
+     */
+    void buildLevels();
+
+    // drops the simplified levels
+    void clearLevels();
+};
+
+#endif
@@ -0,0 +1,189 @@
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+#include <vector>
+#include "Helpers.h"
+#include "MeshLevel.h"
+
+using namespace std;
+
+MeshLevel::MeshLevel()
+{
+    this->error = 0;
+}
+
+/*
+	Unit normal of a triangle in the given stream, zero for degenerate triangles.
+*/
+static Vec3 triangleNormal(const Triangle &triangle, const VertexStream &vertices)
+{
+    Vec3 corners[3];
+    for (int i = 0; i < 3; i++) {
+        int index = triangle.vertexIndices[i];
+        corners[i] = Vec3(vertices.x[index], vertices.y[index], vertices.z[index], -1);
+    }
+    Vec3 normal = crossProductVec3(subtractVec3(corners[1], corners[0]), subtractVec3(corners[2], corners[0]));
+    double length = magnitudeOfVec3(normal);
+    return length > 0 ? multiplyVec3WithScalar(normal, 1 / length) : Vec3(0, 0, 0, -1);
+}
+
+/*
+	Grows each meshlet greedily from the first unassigned triangle, always adding the
+	neighbour whose normal is closest to the meshlet's average normal, until it is full
+	or no neighbour is close enough.
+*/
+void MeshLevel::buildMeshlets(const VertexStream &objectVertices)
+{
+    int triangleCount = triangles.size();
+    vector<Vec3> normals(triangleCount);
+    for (int i = 0; i < triangleCount; i++) {
+        normals[i] = triangleNormal(triangles[i], objectVertices);
+    }
+
+    // triangles around each vertex, as offsets into one array
+    vector<int> firstAround(objectVertices.size() + 1, 0);
+    for (auto &triangle: triangles) {
+        for (int index: triangle.vertexIndices) {
+            firstAround[index + 1]++;
+        }
+    }
+    for (size_t i = 1; i < firstAround.size(); i++) {
+        firstAround[i] += firstAround[i - 1];
+    }
+    vector<int> trianglesAround(firstAround.back());
+    vector<int> filled(firstAround.begin(), firstAround.end() - 1);
+    for (int i = 0; i < triangleCount; i++) {
+        for (int index: triangles[i].vertexIndices) {
+            trianglesAround[filled[index]++] = i;
+        }
+    }
+
+    meshlets.clear();
+    meshletTriangles.clear();
+    vector<bool> assigned(triangleCount, false);
+    vector<int> candidates;
+    for (int seed = 0; seed < triangleCount; seed++) {
+        if (assigned[seed]) {
+            continue;
+        }
+
+        Meshlet meshlet;
+        meshlet.firstTriangle = meshletTriangles.size();
+        Vec3 normalSum(0, 0, 0, -1);
+        candidates.clear();
+
+        int next = seed;
+        while (next >= 0) {
+            assigned[next] = true;
+            meshletTriangles.push_back(next);
+            meshlet.triangleCount++;
+            normalSum = addVec3(normalSum, normals[next]);
+            for (int index: triangles[next].vertexIndices) {
+                for (int i = firstAround[index]; i < firstAround[index + 1]; i++) {
+                    if (!assigned[trianglesAround[i]]) {
+                        candidates.push_back(trianglesAround[i]);
+                    }
+                }
+            }
+            if (meshlet.triangleCount == MESHLET_SIZE) {
+                break;
+            }
+
+            // degenerate triangles have no normal and fit anywhere
+            double sumLength = magnitudeOfVec3(normalSum);
+            next = -1;
+            double bestCos = MESHLET_MIN_NORMAL_COS;
+            for (int candidate: candidates) {
+                if (assigned[candidate]) {
+                    continue;
+                }
+                double cosine = sumLength > 0 && magnitudeOfVec3(normals[candidate]) > 0
+                                ? dotProductVec3(normalSum, normals[candidate]) / sumLength : 1;
+                if (cosine >= bestCos) {
+                    bestCos = cosine;
+                    next = candidate;
+                }
+            }
+        }
+        meshlets.push_back(meshlet);
+    }
+}
+
+/*
+	Numbers the undirected edges by first appearance and lists the triangles bordering each.
+*/
+void MeshLevel::buildEdges()
+{
+    // keyed by the smaller vertex index in the upper half and the larger one in the lower
+    unordered_map<long long, int> edgeOfVertices;
+    vector<int> triangleCounts;
+    triangleEdges.resize(triangles.size() * 3);
+    for (size_t t = 0; t < triangles.size(); t++) {
+        for (int i = 0; i < 3; i++) {
+            int a = triangles[t].vertexIndices[i];
+            int b = triangles[t].vertexIndices[(i + 1) % 3];
+            long long key = (long long) min(a, b) << 32 | max(a, b);
+            auto found = edgeOfVertices.emplace(key, (int) triangleCounts.size());
+            if (found.second) {
+                triangleCounts.push_back(0);
+            }
+            int edge = found.first->second;
+            triangleEdges[t * 3 + i] = edge;
+            triangleCounts[edge]++;
+        }
+    }
+
+    edgeTriangleStart.assign(triangleCounts.size() + 1, 0);
+    for (size_t e = 0; e < triangleCounts.size(); e++) {
+        edgeTriangleStart[e + 1] = edgeTriangleStart[e] + triangleCounts[e];
+    }
+    // filled in triangle order, so every range comes out sorted
+    edgeTriangles.resize(edgeTriangleStart.back());
+    vector<int> filled(edgeTriangleStart.begin(), edgeTriangleStart.end() - 1);
+    for (size_t i = 0; i < triangleEdges.size(); i++) {
+        edgeTriangles[filled[triangleEdges[i]]++] = i / 3;
+    }
+}
+
+/*
+	Recomputes the bounds and normal cone of every meshlet from the world vertices and
+	rebuilds the hierarchy over them. Non-uniform scaling changes the normals, so the
+	cones cannot simply be carried over from object space.
+*/
+void MeshLevel::updateMeshlets(const VertexStream &worldVertices, vector<Meshlet> &worldMeshlets,
+                               Bvh &hierarchy) const
+{
+    worldMeshlets = meshlets;
+    vector<BoundingVolume> meshletBounds(worldMeshlets.size());
+    for (size_t m = 0; m < worldMeshlets.size(); m++) {
+        Meshlet &meshlet = worldMeshlets[m];
+        meshlet.bounds = BoundingVolume();
+
+        Vec3 normalSum(0, 0, 0, -1);
+        for (int i = meshlet.firstTriangle; i < meshlet.firstTriangle + meshlet.triangleCount; i++) {
+            const Triangle &triangle = triangles[meshletTriangles[i]];
+            for (int index: triangle.vertexIndices) {
+                meshlet.bounds.include(Vec3(worldVertices.x[index], worldVertices.y[index], worldVertices.z[index], -1));
+            }
+            normalSum = addVec3(normalSum, triangleNormal(triangle, worldVertices));
+        }
+
+        // the cone is only useful if it is narrower than a hemisphere
+        meshlet.coneValid = false;
+        double sumLength = magnitudeOfVec3(normalSum);
+        if (sumLength > 0) {
+            meshlet.coneAxis = multiplyVec3WithScalar(normalSum, 1 / sumLength);
+            meshlet.coneCos = 1;
+            for (int i = meshlet.firstTriangle; i < meshlet.firstTriangle + meshlet.triangleCount; i++) {
+                Vec3 normal = triangleNormal(triangles[meshletTriangles[i]], worldVertices);
+                if (magnitudeOfVec3(normal) > 0) {
+                    meshlet.coneCos = min(meshlet.coneCos, dotProductVec3(normal, meshlet.coneAxis));
+                }
+            }
+            meshlet.coneSin = sqrt(max(0.0, 1 - meshlet.coneCos * meshlet.coneCos));
+            meshlet.coneValid = meshlet.coneCos > 0;
+        }
+        meshletBounds[m] = meshlet.bounds;
+    }
+    hierarchy.build(meshletBounds, 1);
+}
@@ -0,0 +1,60 @@
+#ifndef __MESH_LEVEL_H__
+#define __MESH_LEVEL_H__
+
+#include <vector>
+#include "Bvh.h"
+#include "Meshlet.h"
+#include "Triangle.h"
+#include "VertexStream.h"
+
+// most triangles in a meshlet
+#define MESHLET_SIZE 64
+// a triangle only joins a meshlet if its normal is within 45 degrees of the meshlet's average normal
+#define MESHLET_MIN_NORMAL_COS 0.7071
+
+using namespace std;
+
+/*
+ * One level of detail of a mesh geometry: its triangles, grouped into meshlets.
+ * Every level refers to the vertices of its geometry through vertexIndices, so
+ * all of them share the world vertices a mesh instance caches.
+ */
+class MeshLevel
+{
+public:
+    vector<Triangle> triangles;
+    // largest distance, in object space, between this level and the full mesh
+    double error;
+
+    // triangle indices grouped by meshlet
+    vector<int> meshletTriangles;
+    // which triangles each meshlet holds; bounds and cones are per instance, in world space
+    vector<Meshlet> meshlets;
+
+    // undirected edges, only built for levels drawn as wireframe. The edge from vertex i to
+    // vertex (i + 1) % 3 of triangle t is triangleEdges[3 * t + i]; the triangles bordering
+    // edge e are edgeTriangles[edgeTriangleStart[e], edgeTriangleStart[e + 1]), in ascending order
+    vector<int> triangleEdges;
+    vector<int> edgeTriangleStart;
+    vector<int> edgeTriangles;
+
+    MeshLevel();
+
+    // partitions the triangles into meshlets, once when the level is built
+    void buildMeshlets(const VertexStream &objectVertices);
+
+    // finds the edges shared by the triangles, so each of them is drawn once
+    void buildEdges();
+
+    bool hasEdges() const {
+        return triangleEdges.size() == triangles.size() * 3;
+    }
+
+    /*
+     * Copies meshlets to worldMeshlets with bounds and cones for the given world
+     * vertices, and builds hierarchy over them with one meshlet per leaf.
+     */
+    void updateMeshlets(const VertexStream &worldVertices, vector<Meshlet> &worldMeshlets, Bvh &hierarchy) const;
+};
+
+#endif
@@ -0,0 +1,214 @@
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+#include "Helpers.h"
+#include "MeshSimplifier.h"
+
+using namespace std;
+
+static Vec3 positionOf(const VertexStream &vertices, int index) {
+    return Vec3(vertices.x[index], vertices.y[index], vertices.z[index], -1);
+}
+
+// unnormalized, its length is twice the area
+static Vec3 normalOf(const Vec3 &p1, const Vec3 &p2, const Vec3 &p3) {
+    return crossProductVec3(subtractVec3(p2, p1), subtractVec3(p3, p1));
+}
+
+MeshSimplifier::MeshSimplifier(const VertexStream &vertices, const vector<Triangle> &triangles) : vertices(vertices),
+                                                                                                   triangles(triangles) {
+    int vertexCount = vertices.size();
+    this->error = 0;
+    this->aliveCount = triangles.size();
+    this->triangleAlive.assign(triangles.size(), true);
+    this->quadrics.assign(vertexCount, Quadric());
+    for (auto &quadric: quadrics) {
+        fill(quadric.q, quadric.q + 10, 0.0);
+    }
+    this->trianglesAround.resize(vertexCount);
+    this->versions.assign(vertexCount, 0);
+    this->vertexAlive.assign(vertexCount, true);
+
+    // every triangle adds its plane to its corners; edges are keyed by their two vertices
+    unordered_map<long long, pair<int, int>> edgeUses; // count and the triangle of the last use
+    for (int t = 0; t < (int) triangles.size(); t++) {
+        const int *corners = triangles[t].vertexIndices;
+        Vec3 p1 = positionOf(vertices, corners[0]);
+        Vec3 normal = normalOf(p1, positionOf(vertices, corners[1]), positionOf(vertices, corners[2]));
+        double length = magnitudeOfVec3(normal);
+        for (int i = 0; i < 3; i++) {
+            if (length > 0) {
+                addPlane(quadrics[corners[i]], normal.x / length, normal.y / length, normal.z / length,
+                         -dotProductVec3(normal, p1) / length, 1);
+            }
+            trianglesAround[corners[i]].push_back(t);
+
+            int a = min(corners[i], corners[(i + 1) % 3]);
+            int b = max(corners[i], corners[(i + 1) % 3]);
+            auto &uses = edgeUses[(long long) a * vertexCount + b];
+            uses.first++;
+            uses.second = t;
+        }
+    }
+
+    for (auto &edge: edgeUses) {
+        int a = edge.first / vertexCount;
+        int b = edge.first % vertexCount;
+        if (edge.second.first == 1) {
+            // a border edge: the plane through it, perpendicular to its triangle, keeps it in place
+            const int *corners = triangles[edge.second.second].vertexIndices;
+            Vec3 normal = normalOf(positionOf(vertices, corners[0]), positionOf(vertices, corners[1]),
+                                   positionOf(vertices, corners[2]));
+            Vec3 pa = positionOf(vertices, a);
+            Vec3 across = crossProductVec3(subtractVec3(positionOf(vertices, b), pa), normal);
+            double length = magnitudeOfVec3(across);
+            if (length > 0) {
+                double d = -dotProductVec3(across, pa) / length;
+                addPlane(quadrics[a], across.x / length, across.y / length, across.z / length, d,
+                         SIMPLIFIER_BORDER_WEIGHT);
+                addPlane(quadrics[b], across.x / length, across.y / length, across.z / length, d,
+                         SIMPLIFIER_BORDER_WEIGHT);
+            }
+        }
+    }
+
+    for (auto &edge: edgeUses) {
+        int a = edge.first / vertexCount;
+        int b = edge.first % vertexCount;
+        pushCollapse(a, b);
+        pushCollapse(b, a);
+    }
+}
+
+void MeshSimplifier::addPlane(Quadric &quadric, double a, double b, double c, double d, double weight) {
+    double terms[4] = {a, b, c, d};
+    int k = 0;
+    for (int i = 0; i < 4; i++) {
+        for (int j = i; j < 4; j++) {
+            quadric.q[k++] += weight * terms[i] * terms[j];
+        }
+    }
+}
+
+/*
+ * Sum of the weighted squared distances from the vertex to the planes of the quadric.
+ */
+double MeshSimplifier::evaluate(const Quadric &quadric, int vertex) const {
+    double p[4] = {vertices.x[vertex], vertices.y[vertex], vertices.z[vertex], 1};
+    double total = 0;
+    int k = 0;
+    for (int i = 0; i < 4; i++) {
+        for (int j = i; j < 4; j++) {
+            total += (i == j ? 1 : 2) * quadric.q[k++] * p[i] * p[j];
+        }
+    }
+    return max(total, 0.0);
+}
+
+void MeshSimplifier::pushCollapse(int from, int to) {
+    Quadric merged;
+    for (int k = 0; k < 10; k++) {
+        merged.q[k] = quadrics[from].q[k] + quadrics[to].q[k];
+    }
+
+    Collapse collapse;
+    collapse.cost = evaluate(merged, to);
+    collapse.from = from;
+    collapse.to = to;
+    collapse.fromVersion = versions[from];
+    collapse.toVersion = versions[to];
+    queue.push(collapse);
+}
+
+/*
+ * Returns true if moving from onto to would turn a surviving triangle over or leave it without area.
+ */
+bool MeshSimplifier::flipsTriangle(int from, int to) const {
+    for (int t: trianglesAround[from]) {
+        const int *corners = triangles[t].vertexIndices;
+        if (!triangleAlive[t] || corners[0] == to || corners[1] == to || corners[2] == to) {
+            continue;
+        }
+
+        Vec3 before[3], after[3];
+        for (int i = 0; i < 3; i++) {
+            before[i] = positionOf(vertices, corners[i]);
+            after[i] = positionOf(vertices, corners[i] == from ? to : corners[i]);
+        }
+        Vec3 normalBefore = normalOf(before[0], before[1], before[2]);
+        Vec3 normalAfter = normalOf(after[0], after[1], after[2]);
+        if (dotProductVec3(normalBefore, normalAfter) <= 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void MeshSimplifier::collapse(int from, int to) {
+    for (int k = 0; k < 10; k++) {
+        quadrics[to].q[k] += quadrics[from].q[k];
+    }
+    vertexAlive[from] = false;
+    versions[from]++;
+    versions[to]++;
+
+    // triangles on the collapsed edge disappear, the others move over to the surviving vertex
+    for (int t: trianglesAround[from]) {
+        int *corners = triangles[t].vertexIndices;
+        if (!triangleAlive[t]) {
+            continue;
+        }
+        if (corners[0] == to || corners[1] == to || corners[2] == to) {
+            triangleAlive[t] = false;
+            aliveCount--;
+            continue;
+        }
+        for (int i = 0; i < 3; i++) {
+            if (corners[i] == from) {
+                corners[i] = to;
+            }
+        }
+        trianglesAround[to].push_back(t);
+    }
+    trianglesAround[from].clear();
+
+    vector<int> &around = trianglesAround[to];
+    around.erase(remove_if(around.begin(), around.end(), [this](int t) {
+        return !triangleAlive[t];
+    }), around.end());
+
+    // every edge at the surviving vertex now costs something else
+    for (int t: around) {
+        for (int corner: triangles[t].vertexIndices) {
+            if (corner != to) {
+                pushCollapse(to, corner);
+                pushCollapse(corner, to);
+            }
+        }
+    }
+}
+
+vector<Triangle> MeshSimplifier::simplify(int targetCount) {
+    while (aliveCount > targetCount && !queue.empty()) {
+        Collapse next = queue.top();
+        queue.pop();
+        if (!vertexAlive[next.from] || !vertexAlive[next.to] ||
+            versions[next.from] != next.fromVersion || versions[next.to] != next.toVersion) {
+            continue;
+        }
+        if (flipsTriangle(next.from, next.to)) {
+            continue;
+        }
+
+        error = max(error, sqrt(next.cost));
+        collapse(next.from, next.to);
+    }
+
+    vector<Triangle> result;
+    for (size_t t = 0; t < triangles.size(); t++) {
+        if (triangleAlive[t]) {
+            result.push_back(triangles[t]);
+        }
+    }
+    return result;
+}
@@ -0,0 +1,71 @@
+#ifndef __MESH_SIMPLIFIER_H__
+#define __MESH_SIMPLIFIER_H__
+
+#include <queue>
+#include <vector>
+#include "Triangle.h"
+#include "VertexStream.h"
+
+// quadrics of the planes through border edges are weighted up so open borders keep their shape
+#define SIMPLIFIER_BORDER_WEIGHT 10
+
+using namespace std;
+
+/*
+ * Quadric error edge collapse (Garland and Heckbert). Every collapse moves one
+ * vertex onto a neighbour, so the simplified triangles keep using the original
+ * vertices and colors through vertexIndices. A collapse that would flip a
+ * triangle over is skipped.
+ */
+class MeshSimplifier
+{
+public:
+    // largest error of any collapse so far, as a distance in the space of the vertices
+    double error;
+
+    MeshSimplifier(const VertexStream &vertices, const vector<Triangle> &triangles);
+
+    /*
+     * Collapses edges, cheapest first, until at most targetCount triangles are left or
+     * no collapse is possible. Call it again with a smaller target to go on from there.
+     * Returns the triangles left, in their original order.
+     */
+    vector<Triangle> simplify(int targetCount);
+
+private:
+    // symmetric 4x4 matrix, upper triangle row by row
+    struct Quadric {
+        double q[10];
+    };
+
+    struct Collapse {
+        double cost;
+        int from, to;
+        unsigned int fromVersion, toVersion;
+
+        bool operator<(const Collapse &other) const {
+            return cost > other.cost;
+        }
+    };
+
+    const VertexStream &vertices;
+    vector<Triangle> triangles;
+    vector<bool> triangleAlive;
+    int aliveCount;
+
+    vector<Quadric> quadrics;
+    // triangles around each vertex, including ones that died or moved away since
+    vector<vector<int>> trianglesAround;
+    // bumped whenever a vertex changes, so queued collapses touching it are known to be stale
+    vector<unsigned int> versions;
+    vector<bool> vertexAlive;
+    priority_queue<Collapse> queue;
+
+    void addPlane(Quadric &quadric, double a, double b, double c, double d, double weight);
+    double evaluate(const Quadric &quadric, int vertex) const;
+    void pushCollapse(int from, int to);
+    bool flipsTriangle(int from, int to) const;
+    void collapse(int from, int to);
+};
+
+#endif
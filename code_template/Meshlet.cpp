@@ -0,0 +1,41 @@
+#include <algorithm>
+#include <cmath>
+#include "Helpers.h"
+#include "Meshlet.h"
+
+using namespace std;
+
+Meshlet::Meshlet() : coneAxis(0, 0, 0, -1) {
+    this->firstTriangle = 0;
+    this->triangleCount = 0;
+    this->coneCos = -1;
+    this->coneSin = 0;
+    this->coneValid = false;
+}
+
+bool Meshlet::facesAway(const Camera &camera) const {
+    if (!coneValid) {
+        return false;
+    }
+
+    // a triangle faces away when its normal makes an angle below 90 degrees with the
+    // direction the camera looks at it from. Over the meshlet that angle is at most
+    // the angle phi to the axis plus the cone half angle.
+    Vec3 direction = camera.gaze;
+    double distance = 1;
+    double radius = 0;
+    if (camera.projectionType == PROJ_PERSPECTIVE) {
+        direction = subtractVec3(bounds.center, camera.pos);
+        distance = magnitudeOfVec3(direction);
+        radius = bounds.radius;
+        if (distance <= radius) {
+            return false;
+        }
+    }
+
+    double cosPhi = dotProductVec3(coneAxis, direction) / distance;
+    double sinPhi = sqrt(max(0.0, 1 - cosPhi * cosPhi));
+    double cosWidest = cosPhi * coneCos - sinPhi * coneSin;
+    // the triangles lie within radius of the center, which changes their distance along a normal by at most radius
+    return cosWidest * distance > radius;
+}
@@ -0,0 +1,40 @@
+#ifndef __MESHLET_H__
+#define __MESHLET_H__
+
+#include "BoundingVolume.h"
+#include "Camera.h"
+#include "Vec3.h"
+
+using namespace std;
+
+/*
+ * A small group of neighbouring triangles with similar normals. Besides its
+ * bounds, a meshlet keeps a cone enclosing the normals of its triangles, which
+ * lets a camera reject all of them at once when they face away from it.
+ */
+class Meshlet
+{
+public:
+    // the triangles are level.meshletTriangles[firstTriangle, firstTriangle + triangleCount)
+    int firstTriangle;
+    int triangleCount;
+
+    // world space, refreshed together with the world vertices of a mesh instance
+    BoundingVolume bounds;
+    Vec3 coneAxis;
+    // cosine and sine of the angle between the axis and the farthest normal
+    double coneCos, coneSin;
+    // false when the normals spread over a hemisphere or more
+    bool coneValid;
+
+    Meshlet();
+
+    /*
+     * Returns true if every triangle of the meshlet is certainly a back face for the
+     * camera. Front faces are counter clockwise: their normal (v2 - v1) x (v3 - v1)
+     * points towards the viewer.
+     */
+    bool facesAway(const Camera &camera) const;
+};
+
+#endif
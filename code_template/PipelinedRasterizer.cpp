@@ -0,0 +1,216 @@
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include "PipelinedRasterizer.h"
+#include "JobSystem.h"
+#include "Scene.h"
+
+using namespace std;
+
+static long long nanosecondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+}
+
+PipelinedRasterizer::PipelinedRasterizer(RenderContext &context, JobSystem &jobs, int tileSize, int laneCount,
+                                         int queueDepth)
+        : context(context), jobs(jobs), grid(context.camera, tileSize, context.scene.options.depthTest),
+          submitted(0), runCapacity(0), runLength(0), nextInRun(0), submitting(false), pendingJobs(0),
+          finished(false), geometryStallNanoseconds(0), rasterStallNanoseconds(0) {
+    // one batch for every queue slot, one being drawn and one being filled
+    int batchCount = queueDepth + 2;
+    batches.resize(batchCount);
+    readers.reset(new atomic<int>[batchCount]);
+    for (int i = 0; i < batchCount; i++) {
+        readers[i] = 0;
+    }
+
+    laneCount = max(laneCount, 1);
+    for (int i = 0; i < laneCount; i++) {
+        Lane *lane = new Lane();
+        lane->queue.reset(new BatchQueue(queueDepth));
+        lane->painter.reset(new Painter(context));
+        lane->scheduled = false;
+        lane->popped = 0;
+        // a lane waits for its first batch from the start
+        lane->idleSince = chrono::steady_clock::now();
+        lanes.emplace_back(lane);
+    }
+    laneJob = [this](int index) {
+        drainLane(index);
+    };
+}
+
+PipelinedRasterizer::~PipelinedRasterizer() {
+    finish();
+}
+
+void PipelinedRasterizer::submit(PrimitiveBatch &batch) {
+    if (batch.empty()) {
+        return;
+    }
+
+    int slot = submitted % batches.size();
+    auto start = chrono::steady_clock::now();
+    bool stalled = false;
+    if (readers[slot].load(memory_order_acquire) != 0) {
+        stalled = true;
+        waitUntil([&] { return readers[slot].load(memory_order_acquire) == 0; });
+    }
+    swap(batches[slot], batch);
+    batch.clear();
+    readers[slot].store(lanes.size(), memory_order_relaxed);
+
+    for (size_t i = 0; i < lanes.size(); i++) {
+        BatchQueue &queue = *lanes[i]->queue;
+        // a full queue has a job draining it, which signals as it makes room
+        if (queue.full()) {
+            stalled = true;
+            waitUntil([&] { return !queue.full(); });
+        }
+        queue.push(&batches[slot]);
+        startLane(i);
+    }
+    if (stalled) {
+        geometryStallNanoseconds += nanosecondsSince(start);
+    }
+    submitted++;
+}
+
+void PipelinedRasterizer::startRun(int count) {
+    if (count > runCapacity) {
+        runCapacity = count;
+        handedOver.reset(new atomic<PrimitiveBatch *>[runCapacity]);
+    }
+    for (int i = 0; i < count; i++) {
+        handedOver[i] = NULL;
+    }
+    runLength = count;
+    nextInRun = 0;
+}
+
+void PipelinedRasterizer::submitInOrder(int index, PrimitiveBatch &batch) {
+    handedOver[index] = &batch;
+    // a call already submitting, possibly further up this thread's stack, takes this batch along
+    while (!submitting.exchange(true)) {
+        int next = nextInRun;
+        while (next < runLength && handedOver[next] != NULL) {
+            submit(*handedOver[next]);
+            next++;
+        }
+        nextInRun = next;
+        submitting = false;
+        // a batch handed over between the last look and clearing the flag was left to this call
+        if (next == runLength || handedOver[next] == NULL) {
+            return;
+        }
+    }
+}
+
+void PipelinedRasterizer::finish() {
+    if (finished) {
+        return;
+    }
+    finished = true;
+
+    waitUntil([this] {
+        for (auto &lane: lanes) {
+            if (lane->scheduled.load()) {
+                return false;
+            }
+        }
+        return true;
+    });
+    // every lane job is past its last signal, only the job system still has to count it as done
+    while (pendingJobs.load(memory_order_acquire) > 0) {
+        this_thread::yield();
+    }
+
+    for (auto &lane: lanes) {
+        lane->painter->commitStats();
+    }
+    RenderStats stats;
+    stats.pipelineBatches = submitted;
+    stats.geometryStallNanoseconds = geometryStallNanoseconds;
+    stats.rasterStallNanoseconds = rasterStallNanoseconds;
+    context.stats.merge(stats);
+}
+
+void PipelinedRasterizer::startLane(int index) {
+    // pairs with the exchange in drainLane: either the running job sees the batch just
+    // pushed, or this sees the job gone and queues a new one
+    Lane &lane = *lanes[index];
+    if (!lane.scheduled.exchange(true)) {
+        rasterStallNanoseconds += nanosecondsSince(lane.idleSince);
+        pendingJobs++;
+        jobs.spawn(laneJob, index, pendingJobs);
+    }
+}
+
+void PipelinedRasterizer::drainLane(int index) {
+    Lane &lane = *lanes[index];
+    while (true) {
+        PrimitiveBatch *batch;
+        while (lane.queue->pop(batch)) {
+            drawBatch(index, *batch);
+            readers[lane.popped % batches.size()].fetch_sub(1, memory_order_release);
+            lane.popped++;
+            signalProgress();
+        }
+
+        lane.idleSince = chrono::steady_clock::now();
+        lane.scheduled.exchange(false);
+        // a batch pushed before the flag was cleared is ours; after that startLane queues a new job
+        if (lane.queue->empty() || lane.scheduled.exchange(true)) {
+            signalProgress();
+            return;
+        }
+    }
+}
+
+void PipelinedRasterizer::drawBatch(int index, const PrimitiveBatch &batch) {
+    Painter &painter = *lanes[index]->painter;
+    int laneCount = lanes.size();
+    for (int primitive: batch.primitives) {
+        int firstX, lastX, firstY, lastY;
+        if (!grid.tilesOf(batch, primitive, firstX, lastX, firstY, lastY)) {
+            continue;
+        }
+        for (int ty = firstY; ty <= lastY; ty++) {
+            for (int tx = firstX; tx <= lastX; tx++) {
+                int tile = ty * grid.tilesX + tx;
+                if (tile % laneCount != index) {
+                    continue;
+                }
+                int minX, maxX, minY, maxY;
+                grid.tileRect(tile, minX, maxX, minY, maxY);
+                painter.setClipRect(minX, maxX, minY, maxY);
+                if (primitive % 2 == 0) {
+                    painter.drawTriangle(batch.triangles[primitive / 2]);
+                } else {
+                    const PrimitiveBatch::LineSetup &line = batch.lines[primitive / 2];
+                    painter.drawLine(line.src, line.dest, line.srcColor, line.destColor);
+                }
+            }
+        }
+    }
+}
+
+void PipelinedRasterizer::signalProgress() {
+    // taking the lock orders this after a waiter's last look at its condition
+    {
+        unique_lock<mutex> guard(progressLock);
+    }
+    progress.notify_all();
+}
+
+void PipelinedRasterizer::waitUntil(const function<bool()> &ready) {
+    while (!ready()) {
+        if (jobs.helpOnce()) {
+            continue;
+        }
+        // lane jobs are only queued by this thread, so with nothing left to run here
+        // the ones it waits on are running on other workers and will signal
+        unique_lock<mutex> guard(progressLock);
+        progress.wait(guard, ready);
+    }
+}
@@ -0,0 +1,126 @@
+#ifndef __PIPELINED_RASTERIZER_H__
+#define __PIPELINED_RASTERIZER_H__
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "BatchQueue.h"
+#include "PrimitiveBatch.h"
+#include "TileGrid.h"
+
+using namespace std;
+
+class JobSystem;
+class Painter;
+class RenderContext;
+
+/*
+ * Rasterizes batches while the geometry stage is still producing them. The screen
+ * tiles are dealt out to lanes, every n-th tile to the same one, and each lane has
+ * its own queue; submit() puts a batch in all of them, so each lane sees every
+ * primitive in submission order and draws the parts inside its tiles. The result
+ * is identical to drawing serially.
+ *
+ * Batches are numbered in runs, one per mesh, and may be set up by several jobs
+ * at once: each job hands its batch to submitInOrder() when done, and whichever
+ * job finds the next batch in line handed over submits it and every ready one
+ * after it. So lanes start on the first batches of a mesh while the later ones
+ * are still set up, and still see them in scene order.
+ *
+ * Lanes are not threads. A lane with batches waiting runs as a job of the shared
+ * JobSystem until its queue is empty and then gives the worker back, so cameras
+ * rendered at the same time add no threads of their own. While the geometry stage
+ * waits for room it runs other jobs, and sleeps when there are none.
+ */
+class PipelinedRasterizer
+{
+public:
+    /*
+     * Sets up laneCount lanes, each with room for queueDepth batches.
+     */
+    PipelinedRasterizer(RenderContext &context, JobSystem &jobs, int tileSize, int laneCount, int queueDepth);
+    ~PipelinedRasterizer();
+
+    /*
+     * Hands the primitives of batch to the lanes, waiting while their queues are full.
+     * batch is left empty but keeps its storage, so it can be filled again.
+     */
+    void submit(PrimitiveBatch &batch);
+
+    /*
+     * Starts a run of count batches numbered from 0. Every batch of the previous
+     * run must have been handed over before.
+     */
+    void startRun(int count);
+
+    /*
+     * Hands over the batch numbered index of the current run, from any thread.
+     * It is submitted once every batch before it is, either right here or by the
+     * call handing over the one it waited for; until then batch must be left alone.
+     */
+    void submitInOrder(int index, PrimitiveBatch &batch);
+
+    /*
+     * Waits until every submitted batch is drawn and adds the counters of the lanes
+     * and the time both sides spent waiting to the context statistics.
+     */
+    void finish();
+
+private:
+    struct Lane {
+        unique_ptr<BatchQueue> queue;
+        unique_ptr<Painter> painter;
+        // set while a job is queued or running for the lane, only that job pops its queue
+        atomic<bool> scheduled;
+        // batches popped so far, the n-th one is in slot n % batches.size()
+        long long popped;
+        // when its queue was last found empty, valid while scheduled is clear
+        chrono::steady_clock::time_point idleSince;
+    };
+
+    RenderContext &context;
+    JobSystem &jobs;
+    TileGrid grid;
+
+    // batches in flight, used round robin; readers counts the lanes yet to draw each one
+    vector<PrimitiveBatch> batches;
+    unique_ptr<atomic<int>[]> readers;
+    long long submitted;
+
+    // batches of the current run handed over so far, null until then, and the next one to submit
+    unique_ptr<atomic<PrimitiveBatch *>[]> handedOver;
+    int runCapacity;
+    int runLength;
+    atomic<int> nextInRun;
+    // set while a call of submitInOrder submits, only that one calls submit
+    atomic<bool> submitting;
+
+    vector<unique_ptr<Lane>> lanes;
+    // lane jobs queued or running, and what they run
+    atomic<int> pendingJobs;
+    function<void(int)> laneJob;
+    // lane jobs signal after every batch and when they stop, so the geometry stage can sleep meanwhile
+    mutex progressLock;
+    condition_variable progress;
+    bool finished;
+
+    long long geometryStallNanoseconds;
+    // summed over the lanes, from running out of batches until the next one is queued
+    long long rasterStallNanoseconds;
+
+    // queues a job for the lane unless one is already queued or running
+    void startLane(int index);
+    // draws the batches queued for the lane until there are none left
+    void drainLane(int index);
+    void drawBatch(int index, const PrimitiveBatch &batch);
+    void signalProgress();
+    // runs other jobs, or sleeps while there are none, until ready() holds; ready() may be
+    // called any number of times and must not change anything
+    void waitUntil(const function<bool()> &ready);
+};
+
+#endif
@@ -0,0 +1,39 @@
+#include <algorithm>
+#include "PrimitiveBatch.h"
+
+using namespace std;
+
+void PrimitiveBatch::clear() {
+    triangles.clear();
+    lines.clear();
+    primitives.clear();
+}
+
+int PrimitiveBatch::addTriangle(const TriangleSetup &setup) {
+    triangles.push_back(setup);
+    primitives.push_back((triangles.size() - 1) * 2);
+    return primitives.back();
+}
+
+int PrimitiveBatch::addLine(const Vec3 &src, const Vec3 &dest, const Color &srcColor, const Color &destColor) {
+    LineSetup line;
+    line.src = src;
+    line.dest = dest;
+    line.srcColor = srcColor;
+    line.destColor = destColor;
+    lines.push_back(line);
+    primitives.push_back((lines.size() - 1) * 2 + 1);
+    return primitives.back();
+}
+
+void PrimitiveBatch::bounds(int primitive, int &minX, int &maxX, int &minY, int &maxY) const {
+    if (primitive % 2 == 0) {
+        const TriangleSetup &setup = triangles[primitive / 2];
+        minX = setup.minX, maxX = setup.maxX, minY = setup.minY, maxY = setup.maxY;
+        return;
+    }
+    // drawLine truncates the endpoints before walking between them
+    const LineSetup &line = lines[primitive / 2];
+    int x1 = line.src.x, x2 = line.dest.x, y1 = line.src.y, y2 = line.dest.y;
+    minX = min(x1, x2), maxX = max(x1, x2), minY = min(y1, y2), maxY = max(y1, y2);
+}
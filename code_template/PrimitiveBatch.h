@@ -0,0 +1,43 @@
+#ifndef __PRIMITIVE_BATCH_H__
+#define __PRIMITIVE_BATCH_H__
+
+#include <vector>
+#include "Color.h"
+#include "TriangleSetup.h"
+#include "Vec3.h"
+
+using namespace std;
+
+/*
+ * Primitives ready to rasterize, kept in the order they were added. The geometry
+ * stage fills one batch per run of triangles, so runs can be set up on different
+ * threads and still be drawn in submission order.
+ */
+class PrimitiveBatch
+{
+public:
+    struct LineSetup {
+        Vec3 src, dest;
+        Color srcColor, destColor;
+    };
+
+    vector<TriangleSetup> triangles;
+    vector<LineSetup> lines;
+    // every primitive in order: index * 2 for triangles, index * 2 + 1 for lines
+    vector<int> primitives;
+
+    bool empty() const {
+        return primitives.empty();
+    }
+
+    void clear();
+
+    // both return the reference of the new primitive in primitives
+    int addTriangle(const TriangleSetup &setup);
+    int addLine(const Vec3 &src, const Vec3 &dest, const Color &srcColor, const Color &destColor);
+
+    // pixel bounding box of a primitive, given by its reference in primitives, before clipping to the canvas
+    void bounds(int primitive, int &minX, int &maxX, int &minY, int &maxY) const;
+};
+
+#endif
@@ -0,0 +1,298 @@
+#include "RasterKernels.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAS_X86_KERNELS 1
+#endif
+
+using namespace std;
+
+template<int depthMode, bool testCoverage, typename Pixel>
+static void rasterizeRect(const TriangleSetup &setup, FrameBuffer &frameBuffer, DepthBuffer *depthBuffer,
+                          int minX, int maxX, int minY, int maxY) {
+    // edge values at (minX, y), stepped by a along x and by b along y
+    long long e0Row = setup.edgeAt(0, minX, minY);
+    long long e1Row = setup.edgeAt(1, minX, minY);
+    long long e2Row = setup.edgeAt(2, minX, minY);
+    for (int y = minY; y <= maxY; ++y) {
+        Pixel *row = frameBuffer.row<Pixel>(y);
+        double *depthRow = depthMode == DEPTH_NONE ? NULL : depthBuffer->row(y);
+        long long e0 = e0Row;
+        long long e1 = e1Row;
+        long long e2 = e2Row;
+        for (int x = minX; x <= maxX; ++x) {
+            if (!testCoverage || setup.inside(e0, e1, e2)) {
+                if (depthMode == DEPTH_NONE) {
+                    storeColor(row[x], setup.colorAt(e0, e1, e2));
+                } else {
+                    double z = setup.depthAt(e0, e1, e2);
+                    if (depthMode == DEPTH_WRITE || z < depthRow[x]) {
+                        depthRow[x] = z;
+                        storeColor(row[x], setup.colorAt(e0, e1, e2));
+                    }
+                }
+            }
+            e0 += setup.a[0];
+            e1 += setup.a[1];
+            e2 += setup.a[2];
+        }
+        e0Row += setup.b[0];
+        e1Row += setup.b[1];
+        e2Row += setup.b[2];
+    }
+}
+
+/*
+ * Packed pixels are depth tested with storeNearest, so several threads may draw
+ * over the same rectangle at once.
+ */
+template<bool testCoverage>
+static void rasterizeRectPacked(const TriangleSetup &setup, FrameBuffer &frameBuffer, int depthMode,
+                                int minX, int maxX, int minY, int maxY) {
+    long long e0Row = setup.edgeAt(0, minX, minY);
+    long long e1Row = setup.edgeAt(1, minX, minY);
+    long long e2Row = setup.edgeAt(2, minX, minY);
+    for (int y = minY; y <= maxY; ++y) {
+        PixelPacked *row = frameBuffer.row<PixelPacked>(y);
+        long long e0 = e0Row;
+        long long e1 = e1Row;
+        long long e2 = e2Row;
+        for (int x = minX; x <= maxX; ++x) {
+            if (!testCoverage || setup.inside(e0, e1, e2)) {
+                if (depthMode == DEPTH_NONE) {
+                    storeColor(row[x], setup.colorAt(e0, e1, e2));
+                } else {
+                    storeNearest(row[x], setup.colorAt(e0, e1, e2), setup.depthAt(e0, e1, e2));
+                }
+            }
+            e0 += setup.a[0];
+            e1 += setup.a[1];
+            e2 += setup.a[2];
+        }
+        e0Row += setup.b[0];
+        e1Row += setup.b[1];
+        e2Row += setup.b[2];
+    }
+}
+
+template<bool testCoverage, typename Pixel>
+static void rasterizeRectFormat(const TriangleSetup &setup, FrameBuffer &frameBuffer, DepthBuffer *depthBuffer,
+                                int depthMode, int minX, int maxX, int minY, int maxY) {
+    if (depthMode == DEPTH_TEST) {
+        rasterizeRect<DEPTH_TEST, testCoverage, Pixel>(setup, frameBuffer, depthBuffer, minX, maxX, minY, maxY);
+    } else if (depthMode == DEPTH_WRITE) {
+        rasterizeRect<DEPTH_WRITE, testCoverage, Pixel>(setup, frameBuffer, depthBuffer, minX, maxX, minY, maxY);
+    } else {
+        rasterizeRect<DEPTH_NONE, testCoverage, Pixel>(setup, frameBuffer, depthBuffer, minX, maxX, minY, maxY);
+    }
+}
+
+void rasterizeRectScalar(const TriangleSetup &setup, FrameBuffer &frameBuffer, DepthBuffer *depthBuffer,
+                         int depthMode, int minX, int maxX, int minY, int maxY) {
+    if (frameBuffer.format == FRAMEBUFFER_RGBA8) {
+        rasterizeRectFormat<true, PixelRGBA8>(setup, frameBuffer, depthBuffer, depthMode, minX, maxX, minY, maxY);
+    } else if (frameBuffer.format == FRAMEBUFFER_FLOAT_RGB) {
+        rasterizeRectFormat<true, PixelFloatRGB>(setup, frameBuffer, depthBuffer, depthMode, minX, maxX, minY, maxY);
+    } else {
+        rasterizeRectPacked<true>(setup, frameBuffer, depthMode, minX, maxX, minY, maxY);
+    }
+}
+
+void fillRect(const TriangleSetup &setup, FrameBuffer &frameBuffer, DepthBuffer *depthBuffer,
+              int depthMode, int minX, int maxX, int minY, int maxY) {
+    if (frameBuffer.format == FRAMEBUFFER_RGBA8) {
+        rasterizeRectFormat<false, PixelRGBA8>(setup, frameBuffer, depthBuffer, depthMode, minX, maxX, minY, maxY);
+    } else if (frameBuffer.format == FRAMEBUFFER_FLOAT_RGB) {
+        rasterizeRectFormat<false, PixelFloatRGB>(setup, frameBuffer, depthBuffer, depthMode, minX, maxX, minY, maxY);
+    } else {
+        rasterizeRectPacked<false>(setup, frameBuffer, depthMode, minX, maxX, minY, maxY);
+    }
+}
+
+#ifdef HAS_X86_KERNELS
+
+/*
+ * Edge values are kept in doubles: they are integers far below 2^53, so stepping
+ * them is exact and e * invDoubleArea rounds exactly like the scalar path.
+ * No FMA is used for the same reason.
+ */
+__attribute__((target("avx2")))
+static inline __m256d interpolate(__m256d alpha, __m256d beta, __m256d ceta, double v0, double v1, double v2) {
+    return _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(alpha, _mm256_set1_pd(v0)),
+                                       _mm256_mul_pd(beta, _mm256_set1_pd(v1))),
+                         _mm256_mul_pd(ceta, _mm256_set1_pd(v2)));
+}
+
+/*
+ * Clamps and truncates the channels exactly like toChannel8 and stores the
+ * lanes set in mask with a single masked 16 byte store.
+ */
+__attribute__((target("avx2")))
+static inline void storeLanes(PixelRGBA8 *pixels, int mask, __m256d r, __m256d g, __m256d b) {
+    __m256d zero = _mm256_setzero_pd();
+    __m256d full = _mm256_set1_pd(255.0);
+    __m128i r8 = _mm256_cvttpd_epi32(_mm256_min_pd(_mm256_max_pd(r, zero), full));
+    __m128i g8 = _mm256_cvttpd_epi32(_mm256_min_pd(_mm256_max_pd(g, zero), full));
+    __m128i b8 = _mm256_cvttpd_epi32(_mm256_min_pd(_mm256_max_pd(b, zero), full));
+    __m128i rgba = _mm_or_si128(_mm_or_si128(r8, _mm_slli_epi32(g8, 8)),
+                                _mm_or_si128(_mm_slli_epi32(b8, 16), _mm_set1_epi32((int) 0xFF000000)));
+    __m128i laneMask = _mm_set_epi32(-((mask >> 3) & 1), -((mask >> 2) & 1), -((mask >> 1) & 1), -(mask & 1));
+    _mm_maskstore_epi32((int *) pixels, laneMask, rgba);
+}
+
+/*
+ * Float pixels are 12 bytes, so the masked store is done lane by lane.
+ */
+__attribute__((target("avx2")))
+static inline void storeLanes(PixelFloatRGB *pixels, int mask, __m256d r, __m256d g, __m256d b) {
+    float rLanes[4], gLanes[4], bLanes[4];
+    _mm_storeu_ps(rLanes, _mm256_cvtpd_ps(r));
+    _mm_storeu_ps(gLanes, _mm256_cvtpd_ps(g));
+    _mm_storeu_ps(bLanes, _mm256_cvtpd_ps(b));
+    for (int lane = 0; lane < 4; lane++) {
+        if (mask & (1 << lane)) {
+            pixels[lane].r = rLanes[lane];
+            pixels[lane].g = gLanes[lane];
+            pixels[lane].b = bLanes[lane];
+        }
+    }
+}
+
+/*
+ * Depth tests and shades the 4 lanes starting at pixel x of the row whose coverage is
+ * given by the covered mask. depthRow is NULL with DEPTH_NONE and never offset then.
+ */
+template<int depthMode, typename Pixel>
+__attribute__((target("avx2")))
+static void shadeLanes(const TriangleSetup &setup, __m256d e0, __m256d e1, __m256d e2, __m256d covered,
+                       Pixel *row, double *depthRow, int x) {
+    __m256d inv = _mm256_set1_pd(setup.invDoubleArea);
+    __m256d alpha = _mm256_mul_pd(e0, inv);
+    __m256d beta = _mm256_mul_pd(e1, inv);
+    __m256d ceta = _mm256_mul_pd(e2, inv);
+
+    if (depthMode != DEPTH_NONE) {
+        double *depths = depthRow + x;
+        __m256d z = interpolate(alpha, beta, ceta, setup.z0, setup.z1, setup.z2);
+        if (depthMode == DEPTH_TEST) {
+            __m256d stored = _mm256_maskload_pd(depths, _mm256_castpd_si256(covered));
+            covered = _mm256_and_pd(covered, _mm256_cmp_pd(z, stored, _CMP_LT_OQ));
+        }
+        _mm256_maskstore_pd(depths, _mm256_castpd_si256(covered), z);
+    }
+
+    int mask = _mm256_movemask_pd(covered);
+    if (mask == 0) {
+        return;
+    }
+    storeLanes(row + x, mask,
+               interpolate(alpha, beta, ceta, setup.c0.r, setup.c1.r, setup.c2.r),
+               interpolate(alpha, beta, ceta, setup.c0.g, setup.c1.g, setup.c2.g),
+               interpolate(alpha, beta, ceta, setup.c0.b, setup.c1.b, setup.c2.b));
+}
+
+__attribute__((target("avx2")))
+static inline __m256d insideMask(__m256d e0, __m256d e1, __m256d e2, const __m256d *threshold, __m256d valid) {
+    __m256d inside = _mm256_and_pd(_mm256_cmp_pd(e0, threshold[0], _CMP_GE_OQ),
+                                   _mm256_cmp_pd(e1, threshold[1], _CMP_GE_OQ));
+    inside = _mm256_and_pd(inside, _mm256_cmp_pd(e2, threshold[2], _CMP_GE_OQ));
+    return _mm256_and_pd(inside, valid);
+}
+
+template<int depthMode, typename Pixel>
+__attribute__((target("avx2")))
+static void rasterizeRowsAvx2(const TriangleSetup &setup, FrameBuffer &frameBuffer, DepthBuffer *depthBuffer,
+                              int minX, int maxX, int minY, int maxY) {
+    __m256d threshold[3] = {_mm256_set1_pd((double) setup.threshold[0]),
+                            _mm256_set1_pd((double) setup.threshold[1]),
+                            _mm256_set1_pd((double) setup.threshold[2])};
+    __m256d laneLo = _mm256_set_pd(3, 2, 1, 0);
+    __m256d laneHi = _mm256_set_pd(7, 6, 5, 4);
+    __m256d step0 = _mm256_set1_pd((double) setup.a[0]);
+    __m256d step1 = _mm256_set1_pd((double) setup.a[1]);
+    __m256d step2 = _mm256_set1_pd((double) setup.a[2]);
+    __m256d step0x8 = _mm256_set1_pd((double) (setup.a[0] * 8));
+    __m256d step1x8 = _mm256_set1_pd((double) (setup.a[1] * 8));
+    __m256d step2x8 = _mm256_set1_pd((double) (setup.a[2] * 8));
+
+    for (int y = minY; y <= maxY; ++y) {
+        Pixel *row = frameBuffer.row<Pixel>(y);
+        double *depthRow = depthMode == DEPTH_NONE ? NULL : depthBuffer->row(y);
+        __m256d base0 = _mm256_set1_pd((double) setup.edgeAt(0, minX, y));
+        __m256d base1 = _mm256_set1_pd((double) setup.edgeAt(1, minX, y));
+        __m256d base2 = _mm256_set1_pd((double) setup.edgeAt(2, minX, y));
+        __m256d e0Lo = _mm256_add_pd(base0, _mm256_mul_pd(step0, laneLo));
+        __m256d e1Lo = _mm256_add_pd(base1, _mm256_mul_pd(step1, laneLo));
+        __m256d e2Lo = _mm256_add_pd(base2, _mm256_mul_pd(step2, laneLo));
+        __m256d e0Hi = _mm256_add_pd(base0, _mm256_mul_pd(step0, laneHi));
+        __m256d e1Hi = _mm256_add_pd(base1, _mm256_mul_pd(step1, laneHi));
+        __m256d e2Hi = _mm256_add_pd(base2, _mm256_mul_pd(step2, laneHi));
+
+        for (int x = minX; x <= maxX; x += 8) {
+            // lanes past maxX are masked off
+            __m256d remaining = _mm256_set1_pd((double) (maxX - x));
+            __m256d validLo = _mm256_cmp_pd(laneLo, remaining, _CMP_LE_OQ);
+            __m256d validHi = _mm256_cmp_pd(laneHi, remaining, _CMP_LE_OQ);
+
+            __m256d coveredLo = insideMask(e0Lo, e1Lo, e2Lo, threshold, validLo);
+            __m256d coveredHi = insideMask(e0Hi, e1Hi, e2Hi, threshold, validHi);
+            if (_mm256_movemask_pd(coveredLo)) {
+                shadeLanes<depthMode>(setup, e0Lo, e1Lo, e2Lo, coveredLo, row, depthRow, x);
+            }
+            if (_mm256_movemask_pd(coveredHi)) {
+                shadeLanes<depthMode>(setup, e0Hi, e1Hi, e2Hi, coveredHi, row, depthRow, x + 4);
+            }
+
+            e0Lo = _mm256_add_pd(e0Lo, step0x8);
+            e1Lo = _mm256_add_pd(e1Lo, step1x8);
+            e2Lo = _mm256_add_pd(e2Lo, step2x8);
+            e0Hi = _mm256_add_pd(e0Hi, step0x8);
+            e1Hi = _mm256_add_pd(e1Hi, step1x8);
+            e2Hi = _mm256_add_pd(e2Hi, step2x8);
+        }
+    }
+}
+
+template<typename Pixel>
+static void rasterizeRectAvx2Format(const TriangleSetup &setup, FrameBuffer &frameBuffer, DepthBuffer *depthBuffer,
+                                    int depthMode, int minX, int maxX, int minY, int maxY) {
+    if (depthMode == DEPTH_TEST) {
+        rasterizeRowsAvx2<DEPTH_TEST, Pixel>(setup, frameBuffer, depthBuffer, minX, maxX, minY, maxY);
+    } else if (depthMode == DEPTH_WRITE) {
+        rasterizeRowsAvx2<DEPTH_WRITE, Pixel>(setup, frameBuffer, depthBuffer, minX, maxX, minY, maxY);
+    } else {
+        rasterizeRowsAvx2<DEPTH_NONE, Pixel>(setup, frameBuffer, depthBuffer, minX, maxX, minY, maxY);
+    }
+}
+
+void rasterizeRectAvx2(const TriangleSetup &setup, FrameBuffer &frameBuffer, DepthBuffer *depthBuffer,
+                       int depthMode, int minX, int maxX, int minY, int maxY) {
+    if (frameBuffer.format == FRAMEBUFFER_RGBA8) {
+        rasterizeRectAvx2Format<PixelRGBA8>(setup, frameBuffer, depthBuffer, depthMode, minX, maxX, minY, maxY);
+    } else if (frameBuffer.format == FRAMEBUFFER_FLOAT_RGB) {
+        rasterizeRectAvx2Format<PixelFloatRGB>(setup, frameBuffer, depthBuffer, depthMode, minX, maxX, minY, maxY);
+    } else {
+        // each lane needs its own compare and swap, which gains nothing over the scalar loop
+        rasterizeRectScalar(setup, frameBuffer, depthBuffer, depthMode, minX, maxX, minY, maxY);
+    }
+}
+
+RasterKernel selectRasterKernel(bool allowSimd) {
+    if (allowSimd && __builtin_cpu_supports("avx2")) {
+        return rasterizeRectAvx2;
+    }
+    return rasterizeRectScalar;
+}
+
+#else
+
+void rasterizeRectAvx2(const TriangleSetup &setup, FrameBuffer &frameBuffer, DepthBuffer *depthBuffer,
+                       int depthMode, int minX, int maxX, int minY, int maxY) {
+    rasterizeRectScalar(setup, frameBuffer, depthBuffer, depthMode, minX, maxX, minY, maxY);
+}
+
+RasterKernel selectRasterKernel(bool allowSimd) {
+    return rasterizeRectScalar;
+}
+
+#endif
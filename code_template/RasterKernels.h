@@ -0,0 +1,49 @@
+#ifndef __RASTER_KERNELS_H__
+#define __RASTER_KERNELS_H__
+
+#include "DepthBuffer.h"
+#include "FrameBuffer.h"
+#include "TriangleSetup.h"
+
+// what a kernel does with the depth buffer
+#define DEPTH_NONE 0  // ignore it
+#define DEPTH_TEST 1  // draw pixels closer than the stored depth and store theirs
+#define DEPTH_WRITE 2 // every pixel is known to pass, only store the depth
+
+using namespace std;
+
+/*
+ * Fills the pixels of [minX, maxX] x [minY, maxY] that are inside the triangle.
+ * The rectangle must already be clipped to the image. depthBuffer may be NULL
+ * only with DEPTH_NONE, or with FRAMEBUFFER_PACKED, whose pixels keep their own
+ * depth: there DEPTH_TEST and DEPTH_WRITE both keep the nearer sample atomically.
+ */
+typedef void (*RasterKernel)(const TriangleSetup &setup, FrameBuffer &frameBuffer, DepthBuffer *depthBuffer,
+                             int depthMode, int minX, int maxX, int minY, int maxY);
+
+/*
+ * Reference implementation, one pixel at a time.
+ */
+void rasterizeRectScalar(const TriangleSetup &setup, FrameBuffer &frameBuffer, DepthBuffer *depthBuffer,
+                         int depthMode, int minX, int maxX, int minY, int maxY);
+
+/*
+ * Fills every pixel of the rectangle without coverage tests. Used for blocks
+ * that are known to be fully inside the triangle.
+ */
+void fillRect(const TriangleSetup &setup, FrameBuffer &frameBuffer, DepthBuffer *depthBuffer,
+              int depthMode, int minX, int maxX, int minY, int maxY);
+
+/*
+ * Evaluates 8 pixels of a row at once. Only call it when the CPU supports AVX2.
+ * Produces exactly the same colors and depths as rasterizeRectScalar.
+ */
+void rasterizeRectAvx2(const TriangleSetup &setup, FrameBuffer &frameBuffer, DepthBuffer *depthBuffer,
+                       int depthMode, int minX, int maxX, int minY, int maxY);
+
+/*
+ * Returns the fastest kernel the running CPU supports, or the scalar one if allowSimd is false.
+ */
+RasterKernel selectRasterKernel(bool allowSimd);
+
+#endif
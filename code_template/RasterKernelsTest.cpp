@@ -0,0 +1,154 @@
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "DepthBuffer.h"
+#include "FrameBuffer.h"
+#include "RasterKernels.h"
+#include "TriangleSetup.h"
+
+// size of the image every case is drawn into
+#define TEST_WIDTH 48
+#define TEST_HEIGHT 40
+
+using namespace std;
+
+/*
+ * Checks that the AVX2 kernel writes exactly the colors and depths of the scalar
+ * one, which stays the reference. Run with make test.
+ */
+
+struct TestTriangle {
+    string name;
+    Vec3 vertices[3];
+};
+
+static int failures = 0;
+
+/*
+ * Small deterministic generator, so every run tests the same triangles.
+ */
+static double nextRandom(unsigned int &state) {
+    state = state * 1103515245u + 12345u;
+    return (state >> 8) / (double) (1 << 24);
+}
+
+/*
+ * Depths that part of every triangle passes, so DEPTH_TEST keeps some pixels and drops others.
+ */
+static void fillDepth(DepthBuffer &depthBuffer) {
+    for (size_t i = 0; i < depthBuffer.depth.size(); i++) {
+        depthBuffer.depth[i] = (i * 37 % 101) / 100.0;
+    }
+}
+
+static bool sameBuffers(FrameBuffer &expectedColors, DepthBuffer &expectedDepths,
+                        FrameBuffer &colors, DepthBuffer &depths) {
+    size_t rowBytes = expectedColors.width * FrameBuffer::pixelSize(expectedColors.format);
+    for (int y = 0; y < expectedColors.height; y++) {
+        if (memcmp(expectedColors.row<unsigned char>(y), colors.row<unsigned char>(y), rowBytes) != 0) {
+            return false;
+        }
+    }
+    return memcmp(expectedDepths.depth.data(), depths.depth.data(), expectedDepths.depth.size() * sizeof(double)) == 0;
+}
+
+/*
+ * Draws [minX, maxX] x [minY, maxY] of the triangle with both kernels into freshly
+ * cleared buffers and compares them.
+ */
+static void compareKernels(const string &name, const TriangleSetup &setup, int format, int depthMode,
+                           int minX, int maxX, int minY, int maxY) {
+    FrameBuffer scalarColors, simdColors;
+    DepthBuffer scalarDepths, simdDepths;
+    Color background(10, 20, 30);
+    scalarColors.reset(TEST_WIDTH, TEST_HEIGHT, format);
+    simdColors.reset(TEST_WIDTH, TEST_HEIGHT, format);
+    scalarColors.clear(background);
+    simdColors.clear(background);
+    scalarDepths.reset(TEST_WIDTH, TEST_HEIGHT);
+    simdDepths.reset(TEST_WIDTH, TEST_HEIGHT);
+    fillDepth(scalarDepths);
+    fillDepth(simdDepths);
+
+    DepthBuffer *scalarTarget = depthMode == DEPTH_NONE ? NULL : &scalarDepths;
+    DepthBuffer *simdTarget = depthMode == DEPTH_NONE ? NULL : &simdDepths;
+    rasterizeRectScalar(setup, scalarColors, scalarTarget, depthMode, minX, maxX, minY, maxY);
+    rasterizeRectAvx2(setup, simdColors, simdTarget, depthMode, minX, maxX, minY, maxY);
+
+    if (!sameBuffers(scalarColors, scalarDepths, simdColors, simdDepths)) {
+        cout << "FAIL " << name << ": format " << format << ", depth mode " << depthMode
+             << ", rect [" << minX << ", " << maxX << "] x [" << minY << ", " << maxY << "]" << endl;
+        failures++;
+    }
+}
+
+/*
+ * Compares the kernels over the whole bounding box and over narrow column ranges
+ * of it, so rows end on every lane of the 8 pixel loop.
+ */
+static void testTriangle(const TestTriangle &triangle) {
+    TriangleSetup setup;
+    Color color1(255, 0, 0), color2(0, 255, 0), color3(40, 80, 300);
+    if (!setup.setup(triangle.vertices[0], triangle.vertices[1], triangle.vertices[2], color1, color2, color3,
+                     0, TEST_WIDTH - 1, 0, TEST_HEIGHT - 1)) {
+        return;
+    }
+
+    int formats[] = {FRAMEBUFFER_RGBA8, FRAMEBUFFER_FLOAT_RGB};
+    int depthModes[] = {DEPTH_NONE, DEPTH_TEST, DEPTH_WRITE};
+    for (int format: formats) {
+        for (int depthMode: depthModes) {
+            compareKernels(triangle.name, setup, format, depthMode, setup.minX, setup.maxX, setup.minY, setup.maxY);
+            for (int width = 1; width <= 17; width++) {
+                for (int offset = 0; offset < 8 && setup.minX + offset + width - 1 <= setup.maxX; offset += 3) {
+                    int minX = setup.minX + offset;
+                    compareKernels(triangle.name + " (narrow)", setup, format, depthMode,
+                                   minX, minX + width - 1, setup.minY, setup.maxY);
+                }
+            }
+        }
+    }
+}
+
+int main() {
+    if (!__builtin_cpu_supports("avx2")) {
+        cout << "SKIP: the CPU does not support AVX2" << endl;
+        return 0;
+    }
+
+    vector<TestTriangle> triangles;
+    // vertices on pixel centers, so whole rows and columns lie exactly on the edges
+    // and only the top-left rule decides whether they are drawn
+    triangles.push_back({"top-left square lower half", {Vec3(4, 4, 0.2, 1), Vec3(30, 4, 0.5, 1), Vec3(30, 30, 0.8, 1)}});
+    triangles.push_back({"top-left square upper half", {Vec3(4, 4, 0.2, 1), Vec3(30, 30, 0.8, 1), Vec3(4, 30, 0.4, 1)}});
+    triangles.push_back({"top-left clockwise", {Vec3(10, 2, 0.3, 1), Vec3(2, 20, 0.6, 1), Vec3(40, 20, 0.1, 1)}});
+    triangles.push_back({"top-left vertical edge", {Vec3(17, 1, 0.5, 1), Vec3(17, 38, 0.5, 1), Vec3(45, 19, 0.9, 1)}});
+    // sub-pixel vertices and triangles smaller than a pixel
+    triangles.push_back({"sub-pixel sliver", {Vec3(3.3, 5.7, 0.1, 1), Vec3(44.6, 6.1, 0.9, 1), Vec3(20.25, 7.9, 0.5, 1)}});
+    triangles.push_back({"sub-pixel tiny", {Vec3(12.4, 12.4, 0.3, 1), Vec3(12.6, 12.45, 0.3, 1), Vec3(12.5, 12.7, 0.3, 1)}});
+    triangles.push_back({"sub-pixel needle", {Vec3(0.5, 0.5, 0.0, 1), Vec3(47.5, 39.2, 1.0, 1), Vec3(47.4, 39.5, 0.7, 1)}});
+
+    unsigned int state = 477;
+    for (int i = 0; i < 200; i++) {
+        TestTriangle triangle;
+        triangle.name = "random " + to_string(i);
+        for (int v = 0; v < 3; v++) {
+            // a little beyond the image, so clipped bounding boxes are covered as well
+            triangle.vertices[v] = Vec3(nextRandom(state) * (TEST_WIDTH + 8) - 4,
+                                        nextRandom(state) * (TEST_HEIGHT + 8) - 4, nextRandom(state), 1);
+        }
+        triangles.push_back(triangle);
+    }
+
+    for (auto &triangle: triangles) {
+        testTriangle(triangle);
+    }
+
+    if (failures > 0) {
+        cout << failures << " comparisons failed" << endl;
+        return 1;
+    }
+    cout << "OK: the AVX2 kernel matches the scalar one on " << triangles.size() << " triangles" << endl;
+    return 0;
+}
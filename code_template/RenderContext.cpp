@@ -0,0 +1,7 @@
+#include "RenderContext.h"
+
+using namespace std;
+
+RenderContext::RenderContext(Scene &scene, Camera &camera) : scene(scene), camera(camera) {
+    this->vertexStamp = 0;
+}
@@ -0,0 +1,64 @@
+#ifndef __RENDER_CONTEXT_H__
+#define __RENDER_CONTEXT_H__
+
+#include <vector>
+#include "DepthBuffer.h"
+#include "FrameBuffer.h"
+#include "RenderStats.h"
+#include "Vec3.h"
+#include "Vec4.h"
+#include "VertexStream.h"
+
+using namespace std;
+
+class Scene;
+class Camera;
+class Mesh;
+class MeshLevel;
+
+/*
+ * Everything one camera writes while it is rendered. The scene itself is only
+ * read, so cameras with their own contexts can render at the same time.
+ */
+class RenderContext
+{
+public:
+    Scene &scene;
+    Camera &camera;
+
+    FrameBuffer frameBuffer;
+    DepthBuffer depthBuffer;
+    RenderStats stats;
+
+    // per vertex outputs of the viewing stage for the meshes in meshDraws
+    VertexStream clipStream;
+    vector<Vec4> clipVertices;
+    vector<Vec3> screenVertices;
+    // vertex i of the current mesh is in clipVertices when vertexStamps[i] == vertexStamp
+    vector<unsigned int> vertexStamps;
+    unsigned int vertexStamp;
+
+    // results of frustum culling for the camera and the current mesh
+    vector<int> visibleMeshes;
+    vector<int> visibleMeshlets;
+    vector<int> visibleTriangles;
+    // per triangle of the wireframe meshes in meshDraws, set if it survived back face culling
+    vector<char> outlinedTriangles;
+
+    // a mesh that survived culling: its triangles are visibleTriangles[firstTriangle, lastTriangle),
+    // its vertex i is at clipVertices[firstVertex + i] and screenVertices[firstVertex + i], and
+    // for wireframe meshes the flag of its triangle t is outlinedTriangles[firstOutlined + t]
+    struct MeshDraw {
+        const Mesh *mesh;
+        const MeshLevel *level;
+        size_t firstTriangle, lastTriangle;
+        int firstVertex;
+        int firstOutlined;
+    };
+    // meshes with data in the arrays above; only sort-last rendering keeps more than the current one
+    vector<MeshDraw> meshDraws;
+
+    RenderContext(Scene &scene, Camera &camera);
+};
+
+#endif
@@ -0,0 +1,136 @@
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include "RenderOptions.h"
+#include "Scene.h"
+
+using namespace std;
+
+/*
+ * Renders scenes in every raster mode and checks that each one gives the image of
+ * the serial pipeline, byte for byte. Run with make test from this directory.
+ */
+
+struct ModeCase {
+    string name;
+    // command line switches, as given to the rasterizer, of the serial reference and of the mode
+    vector<string> reference;
+    vector<string> arguments;
+    // largest difference allowed in an 8 bit channel
+    int tolerance;
+};
+
+// 8 bit channels of every camera, as written to the PPM files
+typedef vector<vector<int>> Images;
+
+static int failures = 0;
+
+static bool parseOptions(const vector<string> &arguments, RenderOptions &options) {
+    vector<char *> argv;
+    for (auto &argument: arguments) {
+        argv.push_back((char *) argument.c_str());
+    }
+    return options.parse(argv.size(), argv.data(), 0);
+}
+
+/*
+ * Renders every camera like Scene::renderCameras does, but keeps the channels
+ * instead of writing them to a file.
+ */
+static Images render(Scene &scene, const RenderOptions &options) {
+    scene.setOptions(options);
+    scene.doModelingTransformations();
+    int rasterMode = scene.selectRasterMode();
+
+    Images images;
+    for (auto camera: scene.cameras) {
+        RenderContext context(scene, *camera);
+        scene.initializeImage(context);
+        scene.forwardRenderingPipeline(context, rasterMode);
+
+        vector<int> channels;
+        for (int y = 0; y < camera->verRes; y++) {
+            for (int x = 0; x < camera->horRes; x++) {
+                Color color = context.frameBuffer.getPixel(x, y);
+                channels.push_back(scene.makeBetweenZeroAnd255(color.r));
+                channels.push_back(scene.makeBetweenZeroAnd255(color.g));
+                channels.push_back(scene.makeBetweenZeroAnd255(color.b));
+            }
+        }
+        images.push_back(channels);
+    }
+    return images;
+}
+
+static void compareImages(const string &scenePath, const ModeCase &mode, const Images &expected,
+                          const Images &images) {
+    for (size_t camera = 0; camera < expected.size(); camera++) {
+        int differing = 0;
+        for (size_t i = 0; i < expected[camera].size(); i++) {
+            if (abs(expected[camera][i] - images[camera][i]) > mode.tolerance) {
+                differing++;
+            }
+        }
+        if (differing > 0) {
+            cout << "FAIL " << scenePath << ", " << mode.name << ": camera " << camera + 1 << " has "
+                 << differing << " channels differing from the serial image" << endl;
+            failures++;
+        }
+    }
+}
+
+int main() {
+    vector<string> scenePaths = {
+        "../inputs_outputs/clipping_example/empty_box_clipped.xml",
+        "../inputs_outputs/culling_enabled_inputs/empty_box.xml",
+        "../inputs_outputs/culling_disabled_inputs/filled_box.xml",
+        "../inputs_outputs/culling_enabled_inputs/sample.xml",
+        "../inputs_outputs/culling_enabled_inputs/horse_and_mug.xml",
+        "../inputs_outputs/different_projection_type/horse_and_mug/horse_and_mug_orthographic.xml",
+        // lines in front of a solid triangle drawn after them, in the same depth tiles
+        "test_inputs/lines_over_solid.xml",
+    };
+    vector<string> depthTested = {};
+    vector<string> drawOrdered = {"-nodepth"};
+    vector<ModeCase> modes = {
+        {"without the coarse pass", depthTested, {"-block", "0"}, 0},
+        {"scalar kernel", depthTested, {"-nosimd"}, 0},
+        // colors are kept unclamped and only truncated on output
+        {"float frame buffer", depthTested, {"-format", "float"}, 1},
+        {"packed frame buffer", depthTested, {"-format", "packed"}, 0},
+        {"tiled", depthTested, {"-threads", "4", "-tile", "24"}, 0},
+        {"shared packed frame buffer", depthTested, {"-threads", "4", "-format", "packed"}, 0},
+        {"sort-last", depthTested, {"-threads", "4", "-sortlast"}, 0},
+        {"pipelined on one worker", depthTested, {"-queue", "1", "-batch", "8"}, 0},
+        {"pipelined", depthTested, {"-threads", "4", "-queue", "2", "-batch", "16"}, 0},
+        {"tiled without the depth test", drawOrdered, {"-nodepth", "-threads", "4", "-tile", "24"}, 0},
+        {"pipelined without the depth test", drawOrdered, {"-nodepth", "-threads", "3", "-queue", "1", "-batch", "8"}, 0},
+    };
+
+    int comparisons = 0;
+    for (auto &scenePath: scenePaths) {
+        Scene scene(scenePath.c_str());
+        map<vector<string>, Images> references;
+        for (auto &mode: modes) {
+            RenderOptions referenceOptions, options;
+            if (!parseOptions(mode.reference, referenceOptions) || !parseOptions(mode.arguments, options)) {
+                failures++;
+                continue;
+            }
+            if (references.find(mode.reference) == references.end()) {
+                references[mode.reference] = render(scene, referenceOptions);
+            }
+            compareImages(scenePath, mode, references[mode.reference], render(scene, options));
+            comparisons++;
+        }
+    }
+
+    if (failures > 0) {
+        cout << failures << " comparisons failed" << endl;
+        return 1;
+    }
+    cout << "OK: " << comparisons << " renders match the serial images" << endl;
+    return 0;
+}
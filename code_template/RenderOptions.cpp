@@ -0,0 +1,131 @@
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include "FrameBuffer.h"
+#include "RenderOptions.h"
+
+using namespace std;
+
+RenderOptions::RenderOptions() {
+    this->threadCount = 1;
+    this->tileSize = 64;
+    this->useSimd = true;
+    this->blockSize = 8;
+    this->printStats = false;
+    this->depthTest = true;
+    this->frameBufferFormat = FRAMEBUFFER_RGBA8;
+    this->lodError = 0;
+    this->batchSize = 256;
+    this->queueDepth = 0;
+    this->sortLast = false;
+}
+
+static bool readInt(int argc, char *argv[], int &i, int minValue, int &value) {
+    if (i + 1 >= argc) {
+        cout << "Error: " << argv[i] << " expects a value" << endl;
+        return false;
+    }
+    char *end;
+    long parsed = strtol(argv[i + 1], &end, 10);
+    if (*end != '\0' || parsed < minValue) {
+        cout << "Error: invalid value " << argv[i + 1] << " for " << argv[i] << endl;
+        return false;
+    }
+    value = (int) parsed;
+    i++;
+    return true;
+}
+
+static bool readDouble(int argc, char *argv[], int &i, double minValue, double &value) {
+    if (i + 1 >= argc) {
+        cout << "Error: " << argv[i] << " expects a value" << endl;
+        return false;
+    }
+    char *end;
+    double parsed = strtod(argv[i + 1], &end);
+    if (*end != '\0' || !(parsed >= minValue)) {
+        cout << "Error: invalid value " << argv[i + 1] << " for " << argv[i] << endl;
+        return false;
+    }
+    value = parsed;
+    i++;
+    return true;
+}
+
+bool RenderOptions::parse(int argc, char *argv[], int first) {
+    for (int i = first; i < argc; i++) {
+        if (strcmp(argv[i], "-threads") == 0) {
+            if (!readInt(argc, argv, i, 0, threadCount)) {
+                return false;
+            }
+        } else if (strcmp(argv[i], "-tile") == 0) {
+            if (!readInt(argc, argv, i, 1, tileSize)) {
+                return false;
+            }
+        } else if (strcmp(argv[i], "-nosimd") == 0) {
+            useSimd = false;
+        } else if (strcmp(argv[i], "-block") == 0) {
+            if (!readInt(argc, argv, i, 0, blockSize)) {
+                return false;
+            }
+        } else if (strcmp(argv[i], "-stats") == 0) {
+            printStats = true;
+        } else if (strcmp(argv[i], "-nodepth") == 0) {
+            depthTest = false;
+        } else if (strcmp(argv[i], "-format") == 0) {
+            if (i + 1 < argc && strcmp(argv[i + 1], "rgba8") == 0) {
+                frameBufferFormat = FRAMEBUFFER_RGBA8;
+            } else if (i + 1 < argc && strcmp(argv[i + 1], "float") == 0) {
+                frameBufferFormat = FRAMEBUFFER_FLOAT_RGB;
+            } else if (i + 1 < argc && strcmp(argv[i + 1], "packed") == 0) {
+                frameBufferFormat = FRAMEBUFFER_PACKED;
+            } else {
+                cout << "Error: -format expects rgba8, float or packed" << endl;
+                return false;
+            }
+            i++;
+        } else if (strcmp(argv[i], "-lod") == 0) {
+            if (!readDouble(argc, argv, i, 0, lodError)) {
+                return false;
+            }
+        } else if (strcmp(argv[i], "-batch") == 0) {
+            if (!readInt(argc, argv, i, 1, batchSize)) {
+                return false;
+            }
+        } else if (strcmp(argv[i], "-queue") == 0) {
+            if (!readInt(argc, argv, i, 0, queueDepth)) {
+                return false;
+            }
+        } else if (strcmp(argv[i], "-sortlast") == 0) {
+            sortLast = true;
+        } else {
+            cout << "Error: unknown option " << argv[i] << endl;
+            return false;
+        }
+    }
+
+    if (threadCount == 0) {
+        threadCount = max(1u, thread::hardware_concurrency());
+    }
+    return true;
+}
+
+void RenderOptions::printUsage(ostream &os) {
+    os << "Please run the rasterizer as:" << endl
+       << "\t./rasterizer <input_file_name> [options]" << endl
+       << "Options:" << endl
+       << "\t-threads <n>\tnumber of worker threads, 0 for all cores (default 1)" << endl
+       << "\t-tile <pixels>\tscreen tile size used by the threaded rasterizer (default 64)" << endl
+       << "\t-nosimd\t\tuse the scalar raster loop even if the CPU supports AVX2" << endl
+       << "\t-block <pixels>\tcoarse rasterization block size, 0 to disable (default 8)" << endl
+       << "\t-stats\t\tprint rendering statistics for every camera" << endl
+       << "\t-nodepth\tdisable the depth buffer, later primitives overwrite earlier ones" << endl
+       << "\t-format <rgba8|float|packed>\tframe buffer pixel format (default rgba8); packed keeps the depth\n"
+       << "\t\t\tin the pixels, so threads draw their triangles without splitting the screen" << endl
+       << "\t-lod <pixels>\tdraw simplified meshes where their error stays below this many pixels, 0 to disable (default 0)" << endl
+       << "\t-batch <triangles>\ttriangles set up per geometry job and passed on together (default 256)" << endl
+       << "\t-queue <batches>\trasterize on the other workers while the geometry is processed, with queues\n"
+       << "\t\t\tthis many batches deep; 0 bins everything into tiles first (default 0)" << endl
+       << "\t-sortlast\tgive every thread an equal share of the triangles to draw into its own buffers,\n"
+       << "\t\t\tthen composite them by depth; ignored with -nodepth, -queue or -format packed" << endl;
+}
@@ -0,0 +1,37 @@
+#ifndef __RENDER_OPTIONS_H__
+#define __RENDER_OPTIONS_H__
+
+#include <iostream>
+
+using namespace std;
+
+/*
+ * Command line switches of the rasterizer. Every switch is optional and the
+ * defaults reproduce the plain serial pipeline.
+ */
+class RenderOptions
+{
+public:
+    int threadCount; // -threads <n>, 0 means one thread per hardware core
+    int tileSize;    // -tile <pixels>, edge length of the square screen tiles used when threadCount > 1
+    bool useSimd;    // cleared by -nosimd to force the scalar raster loop
+    int blockSize;   // -block <pixels>, coarse rasterization block size, 0 disables the coarse pass
+    bool printStats; // -stats, print per camera counters
+    bool depthTest;  // cleared by -nodepth, then draw order decides visibility
+    int frameBufferFormat; // -format rgba8|float|packed, FRAMEBUFFER_RGBA8 by default
+    double lodError; // -lod <pixels>, screen space error allowed for simplified meshes, 0 draws them in full
+    int batchSize;   // -batch <triangles>, triangles the geometry stage sets up per job and hands on together
+    int queueDepth;  // -queue <batches>, overlap geometry and raster with queues this deep, 0 bins into tiles instead
+    bool sortLast;   // -sortlast, split the triangles among the threads instead of the screen, needs the depth test
+
+    RenderOptions();
+
+    /*
+     * Parses argv[first..argc). Returns false and prints the reason on an unknown or malformed switch.
+     */
+    bool parse(int argc, char *argv[], int first);
+
+    static void printUsage(ostream &os);
+};
+
+#endif
@@ -0,0 +1,132 @@
+#include <iomanip>
+#include "RenderStats.h"
+
+using namespace std;
+
+RenderStats::RenderStats() {
+    reset();
+}
+
+RenderStats::RenderStats(const RenderStats &other) {
+    this->blocksRejected = other.blocksRejected;
+    this->blocksAccepted = other.blocksAccepted;
+    this->blocksPartial = other.blocksPartial;
+    this->blocksDepthRejected = other.blocksDepthRejected;
+    this->trianglesDepthRejected = other.trianglesDepthRejected;
+    this->verticesModeled = other.verticesModeled;
+    this->verticesTransformed = other.verticesTransformed;
+    this->matrixMatrixProducts = other.matrixMatrixProducts;
+    this->meshesTested = other.meshesTested;
+    this->meshesCulled = other.meshesCulled;
+    this->meshesSimplified = other.meshesSimplified;
+    this->trianglesSimplifiedAway = other.trianglesSimplifiedAway;
+    this->trianglesTested = other.trianglesTested;
+    this->trianglesCulled = other.trianglesCulled;
+    this->trianglesFacingAway = other.trianglesFacingAway;
+    this->trianglesBackFacing = other.trianglesBackFacing;
+    this->trianglesDegenerate = other.trianglesDegenerate;
+    this->bvhNodesTested = other.bvhNodesTested;
+    this->edgesDrawn = other.edgesDrawn;
+    this->edgesShared = other.edgesShared;
+    this->pipelineBatches = other.pipelineBatches;
+    this->geometryStallNanoseconds = other.geometryStallNanoseconds;
+    this->rasterStallNanoseconds = other.rasterStallNanoseconds;
+}
+
+void RenderStats::reset() {
+    this->blocksRejected = 0;
+    this->blocksAccepted = 0;
+    this->blocksPartial = 0;
+    this->trianglesDepthRejected = 0;
+    this->blocksDepthRejected = 0;
+    this->verticesModeled = 0;
+    this->verticesTransformed = 0;
+    this->matrixMatrixProducts = 0;
+    this->meshesTested = 0;
+    this->meshesCulled = 0;
+    this->meshesSimplified = 0;
+    this->trianglesSimplifiedAway = 0;
+    this->trianglesTested = 0;
+    this->trianglesCulled = 0;
+    this->trianglesFacingAway = 0;
+    this->trianglesBackFacing = 0;
+    this->trianglesDegenerate = 0;
+    this->bvhNodesTested = 0;
+    this->edgesDrawn = 0;
+    this->edgesShared = 0;
+    this->pipelineBatches = 0;
+    this->geometryStallNanoseconds = 0;
+    this->rasterStallNanoseconds = 0;
+}
+
+void RenderStats::merge(const RenderStats &other) {
+    unique_lock<mutex> guard(lock);
+    this->blocksRejected += other.blocksRejected;
+    this->blocksAccepted += other.blocksAccepted;
+    this->blocksPartial += other.blocksPartial;
+    this->trianglesDepthRejected += other.trianglesDepthRejected;
+    this->blocksDepthRejected += other.blocksDepthRejected;
+    this->verticesModeled += other.verticesModeled;
+    this->verticesTransformed += other.verticesTransformed;
+    this->matrixMatrixProducts += other.matrixMatrixProducts;
+    this->meshesTested += other.meshesTested;
+    this->meshesCulled += other.meshesCulled;
+    this->meshesSimplified += other.meshesSimplified;
+    this->trianglesSimplifiedAway += other.trianglesSimplifiedAway;
+    this->trianglesTested += other.trianglesTested;
+    this->trianglesCulled += other.trianglesCulled;
+    this->trianglesFacingAway += other.trianglesFacingAway;
+    this->trianglesBackFacing += other.trianglesBackFacing;
+    this->trianglesDegenerate += other.trianglesDegenerate;
+    this->bvhNodesTested += other.bvhNodesTested;
+    this->edgesDrawn += other.edgesDrawn;
+    this->edgesShared += other.edgesShared;
+    this->pipelineBatches += other.pipelineBatches;
+    this->geometryStallNanoseconds += other.geometryStallNanoseconds;
+    this->rasterStallNanoseconds += other.rasterStallNanoseconds;
+}
+
+static double percentage(long long part, long long total) {
+    return total == 0 ? 0.0 : 100.0 * part / total;
+}
+
+void RenderStats::print(ostream &os, int cameraId) const {
+    long long blocks = blocksRejected + blocksDepthRejected + blocksAccepted + blocksPartial;
+
+    // a vertex used to go through the modeling matrix, two viewing matrices, the projection and the
+    // viewport one at a time for every camera; it now takes the view-projection matrix and the
+    // viewport, plus the modeling matrix when the world space cache is refilled. A matrix-matrix
+    // product is counted as 4 matrix-vector products.
+    long long productsBefore = 5 * verticesTransformed;
+    long long productsNow = 2 * verticesTransformed + verticesModeled + 4 * matrixMatrixProducts;
+
+    os << "Camera " << cameraId << ":" << endl
+       << fixed << setprecision(1)
+       << "\tblocks: " << blocks
+       << " (rejected " << percentage(blocksRejected, blocks) << "%"
+       << ", behind depth " << percentage(blocksDepthRejected, blocks) << "%"
+       << ", fully covered " << percentage(blocksAccepted, blocks) << "%"
+       << ", partial " << percentage(blocksPartial, blocks) << "%)" << endl
+       << "\ttriangles rejected by depth bounds: " << trianglesDepthRejected << endl
+       << "\tvertices moved to world space: " << verticesModeled
+       << (verticesModeled == 0 ? " (all cached)" : "") << endl
+       << "\tvertices transformed: " << verticesTransformed
+       << " (" << productsNow << " matrix-vector products, " << productsBefore - productsNow
+       << " saved by composite matrices and caching)" << endl
+       << "\tmeshes outside the view frustum: " << meshesCulled << " of " << meshesTested << endl
+       << "\tmeshes drawn simplified: " << meshesSimplified << " (" << trianglesSimplifiedAway << " fewer triangles)" << endl
+       << "\ttriangles in meshlets outside the view frustum: " << trianglesCulled << " of " << trianglesTested
+       << " (" << bvhNodesTested << " hierarchy nodes tested)" << endl
+       << "\ttriangles in meshlets facing away: " << trianglesFacingAway << endl
+       << "\ttriangles culled as back faces: " << trianglesBackFacing
+       << ", without area: " << trianglesDegenerate << endl;
+    if (edgesDrawn + edgesShared > 0) {
+        os << "\twireframe edges drawn: " << edgesDrawn << " (" << edgesShared << " shared ones drawn once)" << endl;
+    }
+    if (pipelineBatches > 0) {
+        // the raster stall is summed over all raster lanes
+        os << "	pipelined batches: " << pipelineBatches
+           << " (geometry stalled " << geometryStallNanoseconds / 1e6 << " ms on full queues"
+           << ", raster stalled " << rasterStallNanoseconds / 1e6 << " ms on empty ones)" << endl;
+    }
+}
@@ -0,0 +1,69 @@
+#ifndef __RENDER_STATS_H__
+#define __RENDER_STATS_H__
+
+#include <iostream>
+#include <mutex>
+
+using namespace std;
+
+/*
+ * Counters collected while rendering one camera, printed with -stats.
+ * Painters count into their own instance and merge() it into their render context's
+ * when they are done, so the hot loops never touch shared memory.
+ */
+class RenderStats
+{
+public:
+    // coarse rasterization blocks, classified against the edge functions
+    long long blocksRejected;
+    long long blocksAccepted;
+    long long blocksPartial;
+    // rejected by the coarse depth bounds before any per-pixel work
+    long long trianglesDepthRejected;
+    long long blocksDepthRejected;
+    // vertex processing: world space vertices are cached across cameras and
+    // every camera multiplies them by one view-projection matrix
+    long long verticesModeled;
+    long long verticesTransformed;
+    long long matrixMatrixProducts;
+    // meshes tested against the view frustum, and those skipped before any per-vertex work
+    long long meshesTested;
+    long long meshesCulled;
+    // visible meshes drawn at a simplified level, and the triangles that saved
+    long long meshesSimplified;
+    long long trianglesSimplifiedAway;
+    // triangles of visible meshes, those in meshlets outside the frustum or facing away
+    // from the camera, and hierarchy nodes tested
+    long long trianglesTested;
+    long long trianglesCulled;
+    long long trianglesFacingAway;
+    // triangles rejected one by one as back faces or for having no area on screen
+    long long trianglesBackFacing;
+    long long trianglesDegenerate;
+    long long bvhNodesTested;
+    // edges of outlined wireframe triangles clipped and drawn, and those left to a later triangle sharing them
+    long long edgesDrawn;
+    long long edgesShared;
+    // batches passed from the geometry stage to the raster lanes, and the time the
+    // geometry stage waited for room in their queues and they waited for batches
+    long long pipelineBatches;
+    long long geometryStallNanoseconds;
+    long long rasterStallNanoseconds;
+
+    RenderStats();
+    RenderStats(const RenderStats &other);
+
+    void reset();
+
+    /*
+     * Adds the counters of other to this one. Safe to call from several threads.
+     */
+    void merge(const RenderStats &other);
+
+    void print(ostream &os, int cameraId) const;
+
+private:
+    mutex lock;
+};
+
+#endif
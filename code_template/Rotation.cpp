@@ -1,3 +1,5 @@
+#include <cmath>
+#include "Helpers.h"
 #include "Rotation.h"
 #include <iostream>
 #include <iomanip>
@@ -13,6 +15,24 @@ Rotation::Rotation(int rotationId, double angle, double x, double y, double z)
     this->ux = x;
     this->uy = y;
     this->uz = z;
+    buildMatrix();
+}
+
+void Rotation::buildMatrix()
+{
+    Vec3 u = normalizeVec3(Vec3(ux, uy, uz, -1));
+    double c = cos(angle * M_PI / 180);
+    double s = sin(angle * M_PI / 180);
+    double t = 1 - c;
+
+    // R = cI + (1 - c) uu^T + s[u]x
+    double rotationMatrix[4][4] = {
+            {t * u.x * u.x + c,       t * u.x * u.y - s * u.z, t * u.x * u.z + s * u.y, 0},
+            {t * u.x * u.y + s * u.z, t * u.y * u.y + c,       t * u.y * u.z - s * u.x, 0},
+            {t * u.x * u.z - s * u.y, t * u.y * u.z + s * u.x, t * u.z * u.z + c,       0},
+            {0,                       0,                       0,                       1}
+    };
+    matrix = Matrix4(rotationMatrix);
 }
 
 ostream &operator<<(ostream &os, const Rotation &r)
@@ -2,6 +2,7 @@
 #define __ROTATION_H__
 
 #include <iostream>
+#include "Matrix4.h"
 
 using namespace std;
 
@@ -9,10 +10,19 @@ class Rotation
 {
 public:
     int rotationId;
+    // counterclockwise, in degrees, around the axis (ux, uy, uz) through the origin
     double angle, ux, uy, uz;
+    // built from the values above by buildMatrix
+    Matrix4 matrix;
 
     Rotation();
     Rotation(int rotationId, double angle, double x, double y, double z);
+
+    /*
+     * Fills matrix in closed form with Rodrigues' formula; the axis does not have
+     * to be a unit vector. Call it again after changing the angle or the axis.
+     */
+    void buildMatrix();
     friend ostream &operator<<(ostream &os, const Rotation &r);
 };
 
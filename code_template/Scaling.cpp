@@ -12,6 +12,18 @@ Scaling::Scaling(int scalingId, double sx, double sy, double sz)
     this->sx = sx;
     this->sy = sy;
     this->sz = sz;
+    buildMatrix();
+}
+
+void Scaling::buildMatrix()
+{
+    double scalingMatrix[4][4] = {
+            {sx, 0,  0,  0},
+            {0,  sy, 0,  0},
+            {0,  0,  sz, 0},
+            {0,  0,  0,  1}
+    };
+    matrix = Matrix4(scalingMatrix);
 }
 
 ostream &operator<<(ostream &os, const Scaling &s)
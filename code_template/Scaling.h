@@ -2,6 +2,7 @@
 #define __SCALING_H__
 
 #include <iostream>
+#include "Matrix4.h"
 
 using namespace std;
 
@@ -10,9 +11,14 @@ class Scaling
 public:
     int scalingId;
     double sx, sy, sz;
+    // built from the values above by buildMatrix
+    Matrix4 matrix;
 
     Scaling();
     Scaling(int scalingId, double sx, double sy, double sz);
+
+    // fills matrix; call it again after changing sx, sy or sz
+    void buildMatrix();
     friend ostream &operator<<(ostream &os, const Scaling &s);
 };
 
@@ -1,9 +1,12 @@
+#include <atomic>
 #include <iostream>
 #include <iomanip>
 #include <cstdlib>
 #include <cstring>
 #include <fstream>
 #include <cmath>
+#include <map>
+#include <sstream>
 #include <vector>
 
 #include "Scene.h"
@@ -22,106 +25,57 @@ using namespace tinyxml2;
 using namespace std;
 
 
-void ForwardRenderingPipeline::doModelingTransformations() {
-    for (auto mesh: scene.meshes) {
-        int numberOfTransformations = mesh->numberOfTransformations;
-
-        Matrix4 transformationMatrix = getIdentityMatrix();
-        for (int i = 0; i < numberOfTransformations; i++) {
-            auto transformationId = mesh->transformationIds[i] - 1;
-            auto transformationType = mesh->transformationTypes[i];
-
-            if (transformationType == 't') {
-                auto tx = scene.translations[transformationId]->tx;
-                auto ty = scene.translations[transformationId]->ty;
-                auto tz = scene.translations[transformationId]->tz;
-
-                double translation_matrix[4][4] = {
-                        {1, 0, 0, tx},
-                        {0, 1, 0, ty},
-                        {0, 0, 1, tz},
-                        {0, 0, 0, 1}
-                };
-                transformationMatrix = multiplyMatrixWithMatrix(translation_matrix, transformationMatrix);
-
-            } else if (transformationType == 's') {
-                auto sx = scene.scalings[transformationId]->sx;
-                auto sy = scene.scalings[transformationId]->sy;
-                auto sz = scene.scalings[transformationId]->sz;
-
-                double scaling_matrix[4][4] = {
-                        {sx, 0,  0,  0},
-                        {0,  sy, 0,  0},
-                        {0,  0,  sz, 0},
-                        {0,  0,  0,  1}
-                };
-                transformationMatrix = multiplyMatrixWithMatrix(scaling_matrix, transformationMatrix);
-
-            } else if (transformationType == 'r') {
-                auto rAngle = scene.rotations[transformationId]->angle;
-                auto rx = scene.rotations[transformationId]->ux;
-                auto ry = scene.rotations[transformationId]->uy;
-                auto rz = scene.rotations[transformationId]->uz;
-                // initialize u, declare v and w vectors
-                Vec3 u(rx, ry, rz, -1), v, w;
-                //finding v vector
-                auto minComponent = min(abs(rx), min(abs(ry), abs(rz)));
-                if (minComponent == abs(rx)) {
-                    v = Vec3(0, -rz, ry, -1);
-                } else if (minComponent == abs(ry)) {
-                    v = Vec3(-rz, 0, rx, -1);
+/*
+	Brings the world space vertices and bounds of every mesh up to date and rebuilds
+	the mesh hierarchy. They are shared by all cameras, so this runs once before the
+	cameras start, with one job per mesh. Returns the number of vertices that had to
+	be transformed again.
+*/
+long long Scene::doModelingTransformations() {
+    // meshes with the same transformation chain share its product
+    map<pair<vector<char>, vector<int>>, Matrix4> chainMatrices;
+    vector<const Matrix4 *> modelingMatrices(meshes.size());
+    for (size_t meshIndex = 0; meshIndex < meshes.size(); meshIndex++) {
+        Mesh *mesh = meshes[meshIndex];
+        auto chain = make_pair(mesh->transformationTypes, mesh->transformationIds);
+        auto found = chainMatrices.find(chain);
+        if (found == chainMatrices.end()) {
+            Matrix4 transformationMatrix = getIdentityMatrix();
+            for (int i = 0; i < mesh->numberOfTransformations; i++) {
+                auto transformationId = mesh->transformationIds[i] - 1;
+                auto transformationType = mesh->transformationTypes[i];
+
+                if (transformationType == 't') {
+                    transformationMatrix = multiplyMatrixWithMatrix(translations[transformationId]->matrix, transformationMatrix);
+                } else if (transformationType == 's') {
+                    transformationMatrix = multiplyMatrixWithMatrix(scalings[transformationId]->matrix, transformationMatrix);
+                } else if (transformationType == 'r') {
+                    transformationMatrix = multiplyMatrixWithMatrix(rotations[transformationId]->matrix, transformationMatrix);
                 } else {
-                    v = Vec3(-ry, rx, 0, -1);
+                    cout << "Error: Unknown transformation type" << endl;
                 }
-                //finding w vector
-                w = crossProductVec3(u, v);
-                //normalize v,w
-                v = normalizeVec3(v);
-                w = normalizeVec3(w);
-                //finding rotation matrix
-                double mInv[4][4] = {
-                        {u.x, v.x, w.x, 0},
-                        {u.y, v.y, w.y, 0},
-                        {u.z, v.z, w.z, 0},
-                        {0,   0,   0,   1}
-                };
-
-                double m[4][4] = {
-                        {u.x, u.y, u.z, 0},
-                        {v.x, v.y, v.z, 0},
-                        {w.x, w.y, w.z, 0},
-                        {0,   0,   0,   1}
-                };
-
-                double xRotationMatrix[4][4] = {
-                        {1, 0,                        0,                         0},
-                        {0, cos(rAngle * M_PI / 180), -sin(rAngle * M_PI / 180), 0},
-                        {0, sin(rAngle * M_PI / 180), cos(rAngle * M_PI / 180),  0},
-                        {0, 0,                        0,                         1}
-                };
-                Matrix4 xRotation_m = multiplyMatrixWithMatrix(xRotationMatrix, m);
-                Matrix4 mInv_xRotation_m = multiplyMatrixWithMatrix(mInv, xRotation_m);
-                transformationMatrix = multiplyMatrixWithMatrix(mInv_xRotation_m, transformationMatrix);
-            } else {
-                cout << "Error: Unknown transformation type" << endl;
             }
-
+            found = chainMatrices.emplace(chain, transformationMatrix).first;
         }
+        modelingMatrices[meshIndex] = &found->second;
+    }
 
-        for (auto &triangle: mesh->triangles) {
-            std::vector<Vec3 *> vertices = {&triangle.vertex1, &triangle.vertex2, &triangle.vertex3};
-            for (auto &vertexPtr: vertices) {
-                Vec3 &vertex = *vertexPtr;
-                Vec4 vertices4(vertex.x, vertex.y, vertex.z, 1, -1);
-                Vec4 vertexMatrix_m = multiplyMatrixWithVec4(transformationMatrix, vertices4);
-                vertex.x = vertexMatrix_m.x;
-                vertex.y = vertexMatrix_m.y;
-                vertex.z = vertexMatrix_m.z;
-            }
-
-
+    // world space positions only depend on the transformations, so they are
+    // computed once and reused by every camera
+    atomic<long long> verticesModeled(0);
+    jobs->parallelFor(meshes.size(), [&](int meshIndex) {
+        Mesh *mesh = meshes[meshIndex];
+        if (mesh->updateWorldVertices(*modelingMatrices[meshIndex])) {
+            verticesModeled += mesh->worldVertices.size();
         }
+    });
+
+    vector<BoundingVolume> meshBounds;
+    for (auto mesh: meshes) {
+        meshBounds.push_back(mesh->worldBounds);
     }
+    meshHierarchy.build(meshBounds, 1);
+    return verticesModeled;
 }
 
 void ForwardRenderingPipeline::doViewingTransformations() {
@@ -172,10 +126,11 @@ void ForwardRenderingPipeline::doViewingTransformations() {
 
     double nx = camera.horRes;
     double ny = camera.verRes;
-    double vpMatrixTemp[3][4] = {
+    double vpMatrixTemp[4][4] = {
             {nx / 2.0, 0,      0,   (nx - 1) / 2},
             {0,        ny / 2, 0,   (ny - 1) / 2},
-            {0,        0,      0.5, 0.5}
+            {0,        0,      0.5, 0.5},
+            {0,        0,      0,   1}
     };
     Matrix4 vpMatrix(vpMatrixTemp);
 
@@ -190,149 +145,450 @@ void ForwardRenderingPipeline::doViewingTransformations() {
      * after scaling by id 1
      * 15.6 -20.8 -23.8460894776
      */
-    for (auto &mesh: scene.meshes) {
-        for (auto &triangle: mesh->triangles) {
-            Vec4 vertex1(triangle.vertex1.x, triangle.vertex1.y, triangle.vertex1.z, 1, triangle.vertex1.colorId);
-            Vec4 vertex2(triangle.vertex2.x, triangle.vertex2.y, triangle.vertex2.z, 1, triangle.vertex2.colorId);
-            Vec4 vertex3(triangle.vertex3.x, triangle.vertex3.y, triangle.vertex3.z, 1, triangle.vertex3.colorId);
-
-            vertex1 = multiplyMatrixWithVec4(camToOriginT, vertex1);
-            vertex1 = multiplyMatrixWithVec4(camUvwRotateToAlignWithXyzT, vertex1);
-            vertex2 = multiplyMatrixWithVec4(camToOriginT, vertex2);
-            vertex2 = multiplyMatrixWithVec4(camUvwRotateToAlignWithXyzT, vertex2);
-            vertex3 = multiplyMatrixWithVec4(camToOriginT, vertex3);
-            vertex3 = multiplyMatrixWithVec4(camUvwRotateToAlignWithXyzT, vertex3);
-
-
-            if (camera.projectionType == PROJ_ORTHO) {
-                vertex1 = multiplyMatrixWithVec4(orthMatrix, vertex1);
-                vertex2 = multiplyMatrixWithVec4(orthMatrix, vertex2);
-                vertex3 = multiplyMatrixWithVec4(orthMatrix, vertex3);
-            } else if (camera.projectionType == PROJ_PERSPECTIVE) {
-                vertex1 = multiplyMatrixWithVec4(perMatrix, vertex1);
-                vertex2 = multiplyMatrixWithVec4(perMatrix, vertex2);
-                vertex3 = multiplyMatrixWithVec4(perMatrix, vertex3);
-            }
+    // viewing and projection folded into one matrix, so every world space vertex
+    // takes a single product to reach clip space
+    Matrix4 viewMatrix = multiplyMatrixWithMatrix(camUvwRotateToAlignWithXyzT, camToOriginT);
+    Matrix4 viewProjectionMatrix = multiplyMatrixWithMatrix(
+            camera.projectionType == PROJ_ORTHO ? orthMatrix : perMatrix, viewMatrix);
+    stats.matrixMatrixProducts += 2;
+
+    Frustum frustum(viewProjectionMatrix);
+
+    VertexStream &clipStream = context.clipStream;
+    vector<Vec4> &clipVertices = context.clipVertices;
+    vector<Vec3> &screenVertices = context.screenVertices;
+    size_t firstVertex = 0;
+    auto setVertex = [&](size_t i, Vec4 vertex) {
+        i += firstVertex;
+        clipVertices[i] = vertex;
+
+        // only meaningful for vertices in front of the camera, clipping takes care of the others
+        vertex.perspectiveDivide();
+        vertex = multiplyMatrixWithVec4(vpMatrix, vertex);
+        screenVertices[i] = Vec3(vertex.x, vertex.y, vertex.z, vertex.colorId);
+    };
 
+    // meshes and triangles are drawn in scene order whatever order the hierarchies return them in,
+    // so images without the depth test stay the same
+    vector<int> &visibleMeshes = context.visibleMeshes;
+    visibleMeshes.clear();
+    stats.bvhNodesTested += scene.meshHierarchy.cull(frustum, visibleMeshes);
+    sort(visibleMeshes.begin(), visibleMeshes.end());
+    stats.meshesTested += scene.meshes.size();
+    stats.meshesCulled += scene.meshes.size() - visibleMeshes.size();
+
+    vector<int> &visibleMeshlets = context.visibleMeshlets;
+    vector<int> &visibleTriangles = context.visibleTriangles;
+    // sort-last rendering splits the triangles of all meshes at once, so their vertices are kept side by side;
+    // the other modes hand every mesh on before the next one and reuse the space
+    vector<RenderContext::MeshDraw> &meshDraws = context.meshDraws;
+    meshDraws.clear();
+    clipVertices.clear();
+    screenVertices.clear();
+    visibleTriangles.clear();
+    context.outlinedTriangles.clear();
+    // one per batch of triangles set up at the same time, a single one draws straight to the painter
+    vector<PrimitiveAssembler> assemblers;
+    for (int meshIndex: visibleMeshes) {
+        Mesh *mesh = scene.meshes[meshIndex];
+
+        int levelIndex = mesh->selectLevel(camera, scene.options.lodError);
+        const MeshLevel &level = mesh->geometry->levels[levelIndex];
+        const vector<Meshlet> &meshlets = mesh->levelMeshlets[levelIndex];
+        if (levelIndex > 0) {
+            stats.meshesSimplified++;
+            stats.trianglesSimplifiedAway += mesh->numberOfTriangles - level.triangles.size();
+        }
 
-            if (mesh->type != WIREFRAME) {
-                vertex1.perspectiveDivide();
-                vertex2.perspectiveDivide();
-                vertex3.perspectiveDivide();
-                vertex1 = multiplyMatrixWithVec4(vpMatrix, vertex1);
-                vertex2 = multiplyMatrixWithVec4(vpMatrix, vertex2);
-                vertex3 = multiplyMatrixWithVec4(vpMatrix, vertex3);
-                triangle.vertex1 = Vec3(vertex1.x, vertex1.y, vertex1.z, vertex1.colorId);
-                triangle.vertex2 = Vec3(vertex2.x, vertex2.y, vertex2.z, vertex2.colorId);
-                triangle.vertex3 = Vec3(vertex3.x, vertex3.y, vertex3.z, vertex3.colorId);
-                if (camera.projectionType == PROJ_ORTHO) {
-                    if (!(scene.cullingEnabled && isCullingExists(triangle))) {//Backface Culling
-                        continue;
-                    }
-                } else if (camera.projectionType == PROJ_PERSPECTIVE) {
-                    if (scene.cullingEnabled && isCullingExists(triangle)) {//Backface Culling
-                        continue;
-                    }
-                }
+        visibleMeshlets.clear();
+        stats.bvhNodesTested += mesh->levelHierarchies[levelIndex].cull(frustum, visibleMeshlets);
+        stats.trianglesTested += level.triangles.size();
+        stats.trianglesCulled += level.triangles.size();
 
-                painter.drawTriangle(triangle);
-            }
+        if (sortLastRasterizer == NULL) {
+            meshDraws.clear();
+            visibleTriangles.clear();
+            context.outlinedTriangles.clear();
+        }
+        RenderContext::MeshDraw draw;
+        draw.mesh = mesh;
+        draw.level = &level;
+        draw.firstTriangle = visibleTriangles.size();
+        draw.firstVertex = sortLastRasterizer == NULL ? 0 : clipVertices.size();
+        firstVertex = draw.firstVertex;
+        draw.firstOutlined = context.outlinedTriangles.size();
+        if (mesh->type == WIREFRAME) {
+            context.outlinedTriangles.resize(draw.firstOutlined + level.triangles.size(), 0);
+        }
 
-            if (mesh->type == WIREFRAME) {
-                std::pair<Vec4, Vec4> line12(vertex1, vertex2);
-                std::pair<Vec4, Vec4> line23(vertex2, vertex3);
-                std::pair<Vec4, Vec4> line31(vertex3, vertex1);
-
-                vertex1.perspectiveDivide();
-                vertex2.perspectiveDivide();
-                vertex3.perspectiveDivide();
-                vertex1 = multiplyMatrixWithVec4(vpMatrix, vertex1);
-                vertex2 = multiplyMatrixWithVec4(vpMatrix, vertex2);
-                vertex3 = multiplyMatrixWithVec4(vpMatrix, vertex3);
-                triangle.vertex1 = Vec3(vertex1.x, vertex1.y, vertex1.z, vertex1.colorId);
-                triangle.vertex2 = Vec3(vertex2.x, vertex2.y, vertex2.z, vertex2.colorId);
-                triangle.vertex3 = Vec3(vertex3.x, vertex3.y, vertex3.z, vertex3.colorId);
-                if (scene.cullingEnabled && isCullingExists(triangle)) {//Backface Culling
-                    continue;
+        for (int meshletIndex: visibleMeshlets) {
+            const Meshlet &meshlet = meshlets[meshletIndex];
+            stats.trianglesCulled -= meshlet.triangleCount;
+            if (scene.cullingEnabled && meshlet.facesAway(camera)) {
+                stats.trianglesFacingAway += meshlet.triangleCount;
+                continue;
+            }
+            visibleTriangles.insert(visibleTriangles.end(), level.meshletTriangles.begin() + meshlet.firstTriangle,
+                                    level.meshletTriangles.begin() + meshlet.firstTriangle + meshlet.triangleCount);
+        }
+        draw.lastTriangle = visibleTriangles.size();
+        size_t triangleCount = draw.lastTriangle - draw.firstTriangle;
+        if (triangleCount == level.triangles.size()) {
+            for (size_t i = 0; i < triangleCount; i++) {
+                visibleTriangles[draw.firstTriangle + i] = i;
+            }
+        } else {
+            sort(visibleTriangles.begin() + draw.firstTriangle, visibleTriangles.end());
+        }
+        meshDraws.push_back(draw);
+
+        size_t vertexCount = mesh->worldVertices.size();
+        clipVertices.resize(firstVertex + vertexCount);
+        screenVertices.resize(firstVertex + vertexCount);
+        if (triangleCount * 3 >= vertexCount) {
+            // most vertices are needed, a batch over all of them is cheapest
+            transformPoints(viewProjectionMatrix, mesh->worldVertices, clipStream);
+            int vertexBatches = (vertexCount + GEOMETRY_BATCH_VERTICES - 1) / GEOMETRY_BATCH_VERTICES;
+            scene.jobs->parallelFor(vertexBatches, [&](int batch) {
+                size_t last = min((batch + 1) * (size_t) GEOMETRY_BATCH_VERTICES, vertexCount);
+                for (size_t i = batch * (size_t) GEOMETRY_BATCH_VERTICES; i < last; i++) {
+                    setVertex(i, clipStream.getVec4(i));
+                }
+            });
+            stats.verticesTransformed += vertexCount;
+        } else {
+            // only the vertices of the visible meshlets, each once
+            if (context.vertexStamps.size() < vertexCount) {
+                context.vertexStamps.resize(vertexCount, context.vertexStamp);
+            }
+            if (++context.vertexStamp == 0) {
+                fill(context.vertexStamps.begin(), context.vertexStamps.end(), 0);
+                context.vertexStamp = 1;
+            }
+            for (size_t i = draw.firstTriangle; i < draw.lastTriangle; i++) {
+                for (int index: level.triangles[visibleTriangles[i]].vertexIndices) {
+                    if (context.vertexStamps[index] != context.vertexStamp) {
+                        context.vertexStamps[index] = context.vertexStamp;
+                        setVertex(index, multiplyMatrixWithVec4(viewProjectionMatrix, mesh->worldVertices.getVec4(index)));
+                        stats.verticesTransformed++;
+                    }
                 }
+            }
+        }
 
-                bool line1Visible = clipping(line12.first, line12.second);
-                bool line2Visible = clipping(line23.first, line23.second);
-                bool line3Visible = clipping(line31.first, line31.second);
+        if (sortLastRasterizer != NULL) {
+            continue;
+        }
 
+        // runs of triangles are set up in parallel, then handed on in scene order,
+        // or drawn right away by the worker that set them up when the frame buffer is shared
+        bool collecting = tileRasterizer != NULL || pipelinedRasterizer != NULL;
+        bool batched = collecting || sharedFrameBuffer;
+        size_t batchSize = batched ? scene.options.batchSize : max(triangleCount, (size_t) 1);
+        int batchCount = (triangleCount + batchSize - 1) / batchSize;
+        while (assemblers.size() < (size_t) batchCount) {
+            if (sharedFrameBuffer) {
+                batchPainters.emplace_back(new Painter(context));
+                assemblers.emplace_back(context, *batchPainters.back(), vpMatrix, false);
+            } else {
+                assemblers.emplace_back(context, painter, vpMatrix, collecting);
+            }
+        }
+        auto forEachBatch = [&](const function<void(int, PrimitiveAssembler &, size_t, size_t)> &job) {
+            scene.jobs->parallelFor(batchCount, [&](int batch) {
+                size_t first = draw.firstTriangle + batch * batchSize;
+                size_t last = min(first + batchSize, draw.lastTriangle);
+                job(batch, assemblers[batch], first, last);
+            });
+        };
+        if (mesh->type == WIREFRAME) {
+            // a shared edge is drawn by the last triangle bordering it, which may be in any batch
+            forEachBatch([&](int batch, PrimitiveAssembler &assembler, size_t first, size_t last) {
+                assembler.cullOutlines(draw, first, last);
+            });
+        }
+        if (pipelinedRasterizer != NULL) {
+            pipelinedRasterizer->startRun(batchCount);
+        }
+        forEachBatch([&](int batch, PrimitiveAssembler &assembler, size_t first, size_t last) {
+            assembler.assemble(draw, first, last);
+            if (pipelinedRasterizer != NULL) {
+                // drawn while the later batches of the mesh are still set up
+                pipelinedRasterizer->submitInOrder(batch, assembler.primitives);
+            }
+        });
+        for (int batch = 0; batch < batchCount && tileRasterizer != NULL; batch++) {
+            tileRasterizer->addBatch(assemblers[batch].primitives);
+            assemblers[batch].primitives.clear();
+        }
+    }
 
+    if (sortLastRasterizer != NULL) {
+        // every partition takes an equal share of all visible triangles, in scene order
+        int partitionCount = sortLastRasterizer->size();
+        size_t totalTriangles = visibleTriangles.size();
+        for (int partition = 0; partition < partitionCount; partition++) {
+            assemblers.emplace_back(context, sortLastRasterizer->painter(partition), vpMatrix, false);
+        }
+        auto forEachPartition = [&](bool wireframeOnly, const function<void(PrimitiveAssembler &,
+                const RenderContext::MeshDraw &, size_t, size_t)> &job) {
+            scene.jobs->parallelFor(partitionCount, [&](int partition) {
+                size_t first = totalTriangles * partition / partitionCount;
+                size_t last = totalTriangles * (partition + 1) / partitionCount;
+                for (auto &draw: meshDraws) {
+                    size_t drawFirst = max(first, draw.firstTriangle);
+                    size_t drawLast = min(last, draw.lastTriangle);
+                    if (drawFirst < drawLast && (!wireframeOnly || draw.mesh->type == WIREFRAME)) {
+                        job(assemblers[partition], draw, drawFirst, drawLast);
+                    }
+                }
+            });
+        };
+        // a shared wireframe edge is drawn by the last triangle bordering it, which may be in any partition
+        if (!context.outlinedTriangles.empty()) {
+            forEachPartition(true, [&](PrimitiveAssembler &assembler, const RenderContext::MeshDraw &draw,
+                                       size_t first, size_t last) {
+                assembler.cullOutlines(draw, first, last);
+            });
+        }
+        forEachPartition(false, [&](PrimitiveAssembler &assembler, const RenderContext::MeshDraw &draw,
+                                    size_t first, size_t last) {
+            assembler.assemble(draw, first, last);
+        });
+    }
 
-                line12.first.perspectiveDivide();
-                line12.second.perspectiveDivide();
-                line23.first.perspectiveDivide();
-                line23.second.perspectiveDivide();
-                line31.first.perspectiveDivide();
-                line31.second.perspectiveDivide();
-                // L01
-                line12.first = multiplyMatrixWithVec4(vpMatrix, line12.first);
-                line12.second = multiplyMatrixWithVec4(vpMatrix, line12.second);
+    for (auto &assembler: assemblers) {
+        stats.merge(assembler.stats);
+    }
+}
 
-                // L12
-                line23.first = multiplyMatrixWithVec4(vpMatrix, line23.first);
-                line23.second = multiplyMatrixWithVec4(vpMatrix, line23.second);
+/*
+	Culls, clips and sets up visibleTriangles[first, last) of the given mesh, in order.
+*/
+void PrimitiveAssembler::assemble(const RenderContext::MeshDraw &draw, size_t first, size_t last) {
+    const Mesh &mesh = *draw.mesh;
+    const MeshLevel &level = *draw.level;
+    const Vec4 *clipVertices = context.clipVertices.data() + draw.firstVertex;
+    const Vec3 *screenVertices = context.screenVertices.data() + draw.firstVertex;
+    const char *outlined = context.outlinedTriangles.data() + draw.firstOutlined;
+    for (size_t i = first; i < last; i++) {
+        int triangleIndex = context.visibleTriangles[i];
+        const Triangle &triangle = level.triangles[triangleIndex];
+        const Vec4 &vertex1 = clipVertices[triangle.vertexIndices[0]];
+        const Vec4 &vertex2 = clipVertices[triangle.vertexIndices[1]];
+        const Vec4 &vertex3 = clipVertices[triangle.vertexIndices[2]];
+        const Vec3 &screenVertex1 = screenVertices[triangle.vertexIndices[0]];
+        const Vec3 &screenVertex2 = screenVertices[triangle.vertexIndices[1]];
+        const Vec3 &screenVertex3 = screenVertices[triangle.vertexIndices[2]];
+
+        // wireframe triangles were culled by cullOutlines already
+        if (mesh.type == WIREFRAME ? !outlined[triangleIndex] : isCulled(vertex1, vertex2, vertex3, true)) {
+            continue;
+        }
 
-                // L20
-                line31.first = multiplyMatrixWithVec4(vpMatrix, line31.first);
-                line31.second = multiplyMatrixWithVec4(vpMatrix, line31.second);
+        if (mesh.type != WIREFRAME) {
+            int clipResult = clipper.classify(vertex1, vertex2, vertex3);
+            if (clipResult == CLIP_OUTSIDE) {
+                continue;
+            }
 
+            if (clipResult == CLIP_INSIDE) {
+                drawTriangle(screenVertex1, screenVertex2, screenVertex3,
+                             *scene.colorsOfVertices[screenVertex1.colorId - 1],
+                             *scene.colorsOfVertices[screenVertex2.colorId - 1],
+                             *scene.colorsOfVertices[screenVertex3.colorId - 1]);
+            } else {
+                drawClippedTriangle(vertex1, vertex2, vertex3, vpMatrix);
+            }
+        }
 
-                if (line1Visible) painter.drawLine(line12.first, line12.second);
-                if (line2Visible) painter.drawLine(line23.first, line23.second);
-                if (line3Visible) painter.drawLine(line31.first, line31.second);
+        if (mesh.type == WIREFRAME) {
+            const Vec4 *corners[3] = {&vertex1, &vertex2, &vertex3};
+            for (int corner = 0; corner < 3; corner++) {
+                if (!drawsEdge(draw, triangleIndex, corner)) {
+                    stats.edgesShared++;
+                    continue;
+                }
+                stats.edgesDrawn++;
+
+                // clipping interpolates the endpoint colors, so every line gets its own copies
+                Vec4 src = *corners[corner];
+                Vec4 dest = *corners[(corner + 1) % 3];
+                Color srcColor = *scene.colorsOfVertices[src.colorId - 1];
+                Color destColor = *scene.colorsOfVertices[dest.colorId - 1];
+                if (clipping(src, dest, srcColor, destColor)) {
+                    src.perspectiveDivide();
+                    dest.perspectiveDivide();
+                    drawLine(multiplyMatrixWithVec4(vpMatrix, src), multiplyMatrixWithVec4(vpMatrix, dest),
+                             srcColor, destColor);
+                }
             }
         }
     }
+}
 
+void PrimitiveAssembler::cullOutlines(const RenderContext::MeshDraw &draw, size_t first, size_t last) {
+    const MeshLevel &level = *draw.level;
+    const Vec4 *clipVertices = context.clipVertices.data() + draw.firstVertex;
+    char *outlined = context.outlinedTriangles.data() + draw.firstOutlined;
+    for (size_t i = first; i < last; i++) {
+        int triangleIndex = context.visibleTriangles[i];
+        const Triangle &triangle = level.triangles[triangleIndex];
+        outlined[triangleIndex] = !isCulled(clipVertices[triangle.vertexIndices[0]],
+                                            clipVertices[triangle.vertexIndices[1]],
+                                            clipVertices[triangle.vertexIndices[2]], false);
+    }
 }
 
-void ForwardRenderingPipeline::doRasterization() {
-/*    for (auto &mesh: scene.meshes) {
-        for (auto &triangle: mesh->triangles) {
+/*
+    Triangles are drawn in ascending order. With the depth test the first draw of a pixel
+    keeps it against later ones at the same depth, so the edge goes to the first outlined
+    triangle bordering it; without it the last draw is what stays, so it goes to the last.
+    Either way the image is the one drawing the edge with every triangle gives.
+*/
+bool PrimitiveAssembler::drawsEdge(const RenderContext::MeshDraw &draw, int triangle, int corner) {
+    const MeshLevel &level = *draw.level;
+    const char *outlined = context.outlinedTriangles.data() + draw.firstOutlined;
+    int edge = level.triangleEdges[triangle * 3 + corner];
+    int first = level.edgeTriangleStart[edge];
+    int last = level.edgeTriangleStart[edge + 1] - 1;
+    int step = scene.options.depthTest ? 1 : -1;
+    // the triangle itself is outlined, so the search stops at it at the latest
+    for (int i = step > 0 ? first : last;; i += step) {
+        if (outlined[level.edgeTriangles[i]]) {
+            return level.edgeTriangles[i] == triangle;
+        }
+    }
+}
 
-            if (scene.cullingEnabled && isCullingExists(triangle)) {//Backface Culling
-                continue;
-            }
+void PrimitiveAssembler::drawTriangle(const Vec3 &vertex1, const Vec3 &vertex2, const Vec3 &vertex3,
+                                      const Color &color1, const Color &color2, const Color &color3) {
+    // the bounding box is clamped to the viewport here, so off screen parts cost nothing
+    TriangleSetup setup;
+    if (!setup.setup(vertex1, vertex2, vertex3, color1, color2, color3,
+                     painter.clipMinX, painter.clipMaxX, painter.clipMinY, painter.clipMaxY)) {
+        return;
+    }
+    if (collecting) {
+        primitives.addTriangle(setup);
+    } else {
+        painter.drawTriangle(setup);
+    }
+}
 
-            if (mesh->type == WIREFRAME) {
-                bool line1Visible = clipping(triangle.vertex1, triangle.vertex2);
-                bool line2Visible = clipping(triangle.vertex2, triangle.vertex3);
-                bool line3Visible = clipping(triangle.vertex3, triangle.vertex1);
-                painter.drawLine(triangle.vertex1, triangle.vertex2);
-                painter.drawLine(triangle.vertex2, triangle.vertex3);
-                painter.drawLine(triangle.vertex3, triangle.vertex1);
-            } else {
-                //painter.drawTriangle(triangle);
-            }
+/*
+    The vertices are in clip space, before the perspective divide. The clipped
+    polygon is convex, so it is drawn as a fan around its first vertex.
+*/
+void PrimitiveAssembler::drawClippedTriangle(const Vec4 &vertex1, const Vec4 &vertex2, const Vec4 &vertex3,
+                                             const Matrix4 &vpMatrix) {
+    int count = clipper.clip(vertex1, vertex2, vertex3,
+                             *scene.colorsOfVertices[vertex1.colorId - 1],
+                             *scene.colorsOfVertices[vertex2.colorId - 1],
+                             *scene.colorsOfVertices[vertex3.colorId - 1]);
+
+    Vec3 screenVertices[MAX_CLIPPED_VERTICES];
+    for (int i = 0; i < count; i++) {
+        Vec4 vertex = clipper.vertices[i];
+        vertex.perspectiveDivide();
+        vertex = multiplyMatrixWithVec4(vpMatrix, vertex);
+        screenVertices[i] = Vec3(vertex.x, vertex.y, vertex.z, vertex.colorId);
+    }
 
-        }
-    }*/
+    for (int i = 1; i + 1 < count; i++) {
+        drawTriangle(screenVertices[0], screenVertices[i], screenVertices[i + 1],
+                     clipper.colors[0], clipper.colors[i], clipper.colors[i + 1]);
+    }
 }
 
-ForwardRenderingPipeline::ForwardRenderingPipeline(Scene &scene1, Camera &camera1) : scene(scene1),
-                                                                                     camera(camera1),
-                                                                                     painter(scene, camera) {
+void PrimitiveAssembler::drawLine(const Vec4 &src, const Vec4 &dest, const Color &srcColor, const Color &destColor) {
+    Vec3 src3(src.x, src.y, src.z, src.colorId);
+    Vec3 dest3(dest.x, dest.y, dest.z, dest.colorId);
+    if (collecting) {
+        primitives.addLine(src3, dest3, srcColor, destColor);
+    } else {
+        painter.drawLine(src3, dest3, srcColor, destColor);
+    }
+}
 
+/*
+    Serial, pipelined and sort-last rasterization happen while the geometry is processed.
+    Only the binned primitives of the tiled rasterizer are left to draw here, or the
+    sort-last partitions to composite.
+*/
+void ForwardRenderingPipeline::doRasterization() {
+    if (tileRasterizer != NULL) {
+        tileRasterizer->flush(*scene.jobs);
+    }
+    if (pipelinedRasterizer != NULL) {
+        pipelinedRasterizer->finish();
+    }
+    if (sortLastRasterizer != NULL) {
+        sortLastRasterizer->composite(*scene.jobs);
+    }
+    for (auto &batchPainter: batchPainters) {
+        batchPainter->commitStats();
+    }
+    painter.commitStats();
+    context.stats.merge(stats);
+}
+
+ForwardRenderingPipeline::ForwardRenderingPipeline(RenderContext &context, int rasterMode) : context(context),
+                                                                                             scene(context.scene),
+                                                                                             camera(context.camera),
+                                                                                             painter(context),
+                                                                                             tileRasterizer(NULL),
+                                                                                             pipelinedRasterizer(NULL),
+                                                                                             sortLastRasterizer(NULL),
+                                                                                             sharedFrameBuffer(rasterMode == RASTER_SHARED) {
+    if (rasterMode == RASTER_TILED) {
+        tileRasterizer = new TileRasterizer(context, scene.options.tileSize);
+    } else if (rasterMode == RASTER_PIPELINED) {
+        // one lane for every worker besides the one running the geometry stage
+        pipelinedRasterizer = new PipelinedRasterizer(context, *scene.jobs, scene.options.tileSize,
+                                                      scene.jobs->size() - 1, scene.options.queueDepth);
+    } else if (rasterMode == RASTER_SORT_LAST) {
+        sortLastRasterizer = new SortLastRasterizer(context, scene.jobs->size());
+    }
+}
 
+ForwardRenderingPipeline::~ForwardRenderingPipeline() {
+    delete tileRasterizer;
+    delete pipelinedRasterizer;
+    delete sortLastRasterizer;
 }
 
-bool ForwardRenderingPipeline::isCullingExists(Triangle &triangle) {
-    Vec3 vertex1 = triangle.vertex1;
-    Vec3 vertex2 = triangle.vertex2;
-    Vec3 vertex3 = triangle.vertex3;
+PrimitiveAssembler::PrimitiveAssembler(RenderContext &context, Painter &painter, const Matrix4 &vpMatrix, bool collecting)
+        : context(context), scene(context.scene), painter(painter),
+          clipper(context.camera.horRes, context.camera.verRes), vpMatrix(vpMatrix), collecting(collecting) {}
 
-    Vec3 v1 = subtractVec3(vertex2, vertex1);
-    Vec3 v2 = subtractVec3(vertex3, vertex1);
-    Vec3 normal = normalizeVec3(crossProductVec3(v1, v2));
-    bool culling_exists = dotProductVec3(normal, vertex1) < 0;
-    return culling_exists;
+/*
+	Backface culling on the determinant of the clip space x, y and w of the vertices.
+	For vertices in front of the camera it has the sign of the projected triangle's
+	area, positive for counter clockwise front faces, and it stays right for triangles
+	crossing the camera plane, so it runs before clipping for both projection types.
+	A zero determinant means the triangle has no area on screen.
+*/
+bool PrimitiveAssembler::isCulled(const Vec4 &vertex1, const Vec4 &vertex2, const Vec4 &vertex3, bool solid) {
+    double determinant = vertex1.x * (vertex2.y * vertex3.t - vertex3.y * vertex2.t)
+                         - vertex2.x * (vertex1.y * vertex3.t - vertex3.y * vertex1.t)
+                         + vertex3.x * (vertex1.y * vertex2.t - vertex2.y * vertex1.t);
+    if (determinant == 0) {
+        // an edge-on wireframe triangle still shows its edges unless culling is on
+        if (solid || scene.cullingEnabled) {
+            stats.trianglesDegenerate++;
+            return true;
+        }
+        return false;
+    }
+    if (scene.cullingEnabled && determinant < 0) {
+        stats.trianglesBackFacing++;
+        return true;
+    }
+    return false;
 }
 
-bool ForwardRenderingPipeline::isVisible(double den, double num, double &t_E, double &t_L) {
+bool PrimitiveAssembler::isVisible(double den, double num, double &t_E, double &t_L) {
     double t = num / den;
     if (den > 0) {
         if (t > t_L) {
@@ -355,10 +611,7 @@ bool ForwardRenderingPipeline::isVisible(double den, double num, double &t_E, do
 }
 
 
-bool ForwardRenderingPipeline::clipping(Vec4 &vertex1, Vec4 &vertex2) { //Liang-Barsky Algorithm is implemented
-    Color *color1 = scene.colorsOfVertices[vertex1.colorId - 1];
-    Color *color2 = scene.colorsOfVertices[vertex2.colorId - 1];
-
+bool PrimitiveAssembler::clipping(Vec4 &vertex1, Vec4 &vertex2, Color &color1, Color &color2) { //Liang-Barsky Algorithm is implemented
     double t_E = 0;
     double t_L = 1;
 
@@ -367,9 +620,9 @@ bool ForwardRenderingPipeline::clipping(Vec4 &vertex1, Vec4 &vertex2) { //Liang-
     double dz = vertex2.z - vertex1.z;
 
     Color dc;
-    dc.r = color2->r - color1->r;
-    dc.g = color2->g - color1->g;
-    dc.b = color2->b - color1->b;
+    dc.r = color2.r - color1.r;
+    dc.g = color2.g - color1.g;
+    dc.b = color2.b - color1.b;
 
     double x_min = -1;
     double x_max = 1;
@@ -390,17 +643,17 @@ bool ForwardRenderingPipeline::clipping(Vec4 &vertex1, Vec4 &vertex2) { //Liang-
                                 vertex2.x = vertex1.x + t_L * dx;
                                 vertex2.y = vertex1.y + t_L * dy;
                                 vertex2.z = vertex1.z + t_L * dz;
-                                color2->r = color1->r + t_L * dc.r;
-                                color2->g = color1->g + t_L * dc.g;
-                                color2->b = color1->b + t_L * dc.b;
+                                color2.r = color1.r + t_L * dc.r;
+                                color2.g = color1.g + t_L * dc.g;
+                                color2.b = color1.b + t_L * dc.b;
                             }
                             if (t_E > 0) {
                                 vertex1.x = vertex1.x + t_E * dx;
                                 vertex1.y = vertex1.y + t_E * dy;
                                 vertex1.z = vertex1.z + t_E * dz;
-                                color1->r = color1->r + t_E * dc.r;
-                                color1->g = color1->g + t_E * dc.g;
-                                color1->b = color1->b + t_E * dc.b;
+                                color1.r = color1.r + t_E * dc.r;
+                                color1.g = color1.g + t_E * dc.g;
+                                color1.b = color1.b + t_E * dc.b;
                             }
                         }
                     }
@@ -414,12 +667,24 @@ bool ForwardRenderingPipeline::clipping(Vec4 &vertex1, Vec4 &vertex2) { //Liang-
 
 void Painter::draw(int x, int y, Color color) {
     if (onCanvas(x, y)) {
-        scene.image[x][y] = color;
+        frameBuffer.setPixel(x, y, color);
     }
 
 }
 
-void Painter::drawLine(Vec3 &src, Vec3 &dest) {
+void Painter::draw(int x, int y, Color color, double depth) {
+    if (!onCanvas(x, y)) {
+        return;
+    }
+    if (depthTest && frameBuffer.format == FRAMEBUFFER_PACKED) {
+        frameBuffer.setPixelIfNearer(x, y, color, depth);
+    } else if (!depthTest || depthBuffer.testAndSet(x, y, depth)) {
+        frameBuffer.setPixel(x, y, color);
+    }
+}
+
+
+void Painter::drawLine(const Vec3 &src, const Vec3 &dest, const Color &srcColor, const Color &destColor) {
     // midpoint algorithm
     int x1 = src.x;
     int x2 = dest.x;
@@ -430,7 +695,7 @@ void Painter::drawLine(Vec3 &src, Vec3 &dest) {
     int dx = x2 - x1;
     double m = (double) dy / dx;
     if (dx < 0) {
-        drawLine(dest, src);
+        drawLine(dest, src, destColor, srcColor);
     } else {
 
         int slopeSign;
@@ -442,15 +707,15 @@ void Painter::drawLine(Vec3 &src, Vec3 &dest) {
             slopeSign = 1;
         }
 
-        const Color &c0 = *scene.colorsOfVertices[src.colorId - 1];
-        const Color &c1 = *scene.colorsOfVertices[dest.colorId - 1];
+        const Color &c0 = srcColor;
+        const Color &c1 = destColor;
         if (-1 < m && m < 1) {
 
             int y = y1;
             int d = 2 * -dy + dx;
             for (int x = x1; x < x2; ++x) {
                 double alpha = (double) (x - x1) / (x2 - x1);
-                draw(x, y, c0.interpolate(c1, alpha));
+                draw(x, y, c0.interpolate(c1, alpha), (1 - alpha) * src.z + alpha * dest.z);
                 d += 2 * -dy;
                 if (d < 0) { // choose NE
                     y += slopeSign;
@@ -462,7 +727,7 @@ void Painter::drawLine(Vec3 &src, Vec3 &dest) {
             int d = 2 * -dx + dy;
             for (int y = y1; y != y2; y += slopeSign) {
                 double alpha = (double) (y - y1) / (y2 - y1);
-                draw(x, y, c0.interpolate(c1, alpha));
+                draw(x, y, c0.interpolate(c1, alpha), (1 - alpha) * src.z + alpha * dest.z);
                 d += 2 * -dx;
                 if (d < 0) { // choose NE
                     x++;
@@ -476,37 +741,106 @@ void Painter::drawLine(Vec3 &src, Vec3 &dest) {
 }
 
 bool Painter::onCanvas(int x, int y) const {
-    return 0 < x && x < camera.horRes &&
-           0 < y && y < camera.verRes;
+    return clipMinX <= x && x <= clipMaxX &&
+           clipMinY <= y && y <= clipMaxY;
 }
 
 
-Painter::Painter(Scene &scene, Camera &camera) : scene(scene), camera(camera) {}
-
-void Painter::drawTriangle(Triangle &triangle) {
-    int left = std::min(triangle.vertex1.x, std::min(triangle.vertex2.x, triangle.vertex3.x));
-    int right = std::max(triangle.vertex1.x, std::max(triangle.vertex2.x, triangle.vertex3.x));
-    int top = std::min(triangle.vertex1.y, std::min(triangle.vertex2.y, triangle.vertex3.y));
-    int bottom = std::max(triangle.vertex1.y, std::max(triangle.vertex2.y, triangle.vertex3.y));
-    const Color &c0 = *scene.colorsOfVertices[triangle.vertex1.colorId - 1];
-    const Color &c1 = *scene.colorsOfVertices[triangle.vertex2.colorId - 1];
-    const Color &c2 = *scene.colorsOfVertices[triangle.vertex3.colorId - 1];
-    for (int x = left; x <= right; ++x) {
-        for (int y = top; y <= bottom; ++y) {
-            double alpha = triangle.f12(x, y) / (double) triangle.f12(triangle.vertex1.x, triangle.vertex1.y);
-            double beta = triangle.f20(x, y) / (double) triangle.f20(triangle.vertex2.x, triangle.vertex2.y);
-            double ceta = triangle.f01(x, y) / (double) triangle.f01(triangle.vertex3.x, triangle.vertex3.y);
-            if (alpha >= 0 && beta >= 0 && ceta >= 0) {
-                draw(x, y, c0.interpolate(c1, c2, alpha, beta, ceta));
-            }
+Painter::Painter(RenderContext &context) : Painter(context, context.frameBuffer, context.depthBuffer) {}
+
+Painter::Painter(RenderContext &context, FrameBuffer &frameBuffer, DepthBuffer &depthBuffer)
+        : context(context), scene(context.scene), camera(context.camera), frameBuffer(frameBuffer), depthBuffer(depthBuffer) {
+    rasterKernel = selectRasterKernel(scene.options.useSimd);
+    depthTest = scene.options.depthTest;
+    setClipRect(1, camera.horRes - 1, 1, camera.verRes - 1);
+}
+
+void Painter::commitStats() {
+    context.stats.merge(stats);
+    stats.reset();
+}
+
+void Painter::setClipRect(int minX, int maxX, int minY, int maxY) {
+    // column and row 0 are never drawn, matching the original canvas test
+    clipMinX = std::max(minX, 1);
+    clipMaxX = std::min(maxX, camera.horRes - 1);
+    clipMinY = std::max(minY, 1);
+    clipMaxY = std::min(maxY, camera.verRes - 1);
+}
+
+void Painter::drawTriangle(const TriangleSetup &setup) {
+    int minX = std::max(setup.minX, clipMinX);
+    int maxX = std::min(setup.maxX, clipMaxX);
+    int minY = std::max(setup.minY, clipMinY);
+    int maxY = std::min(setup.maxY, clipMaxY);
+    if (minX > maxX || minY > maxY) {
+        return;
+    }
+
+    // packed pixels carry their own depth and the depth buffer is left alone, Hi-Z included
+    bool useDepthBuffer = depthTest && frameBuffer.format != FRAMEBUFFER_PACKED;
+    DepthBuffer *depthTarget = useDepthBuffer ? &depthBuffer : NULL;
+    int depthMode = depthTest ? DEPTH_TEST : DEPTH_NONE;
+
+    // whole triangle behind everything already drawn in its bounding box,
+    // only asked for small boxes as the cost grows with the number of tiles
+    if (useDepthBuffer && (maxX - minX) * (maxY - minY) <= 64 * HIZ_TILE_SIZE * HIZ_TILE_SIZE) {
+        double nearest, farthest;
+        setup.depthRange(minX, maxX, minY, maxY, nearest, farthest);
+        if (nearest >= depthBuffer.farthestIn(minX, maxX, minY, maxY)) {
+            stats.trianglesDepthRejected++;
+            return;
         }
     }
-}
 
-void Painter::drawLine(Vec4 &src, Vec4 &dest) {
-    Vec3 src3(src.x, src.y, src.z, src.colorId);
-    Vec3 dest3(dest.x, dest.y, dest.z, dest.colorId);
-    drawLine(src3, dest3);
+    int blockSize = scene.options.blockSize;
+    if (blockSize == 0) {
+        rasterKernel(setup, frameBuffer, depthTarget, depthMode, minX, maxX, minY, maxY);
+        if (useDepthBuffer) {
+            depthBuffer.updateTiles(minX, maxX, minY, maxY);
+        }
+        return;
+    }
+
+    // coarse pass over the block grid, only partially covered blocks need per-pixel tests
+    for (int blockX = minX - minX % blockSize; blockX <= maxX; blockX += blockSize) {
+        int x0 = std::max(blockX, minX);
+        int x1 = std::min(blockX + blockSize - 1, maxX);
+        for (int blockY = minY - minY % blockSize; blockY <= maxY; blockY += blockSize) {
+            int y0 = std::max(blockY, minY);
+            int y1 = std::min(blockY + blockSize - 1, maxY);
+
+            int coverage = setup.classifyRect(x0, x1, y0, y1);
+            if (coverage == RECT_OUTSIDE) {
+                stats.blocksRejected++;
+                continue;
+            }
+
+            int blockDepthMode = depthMode;
+            if (useDepthBuffer) {
+                double nearest, farthest;
+                setup.depthRange(x0, x1, y0, y1, nearest, farthest);
+                if (nearest >= depthBuffer.farthestIn(x0, x1, y0, y1)) {
+                    stats.blocksDepthRejected++;
+                    continue;
+                }
+                if (farthest < depthBuffer.nearestIn(x0, x1, y0, y1)) {
+                    blockDepthMode = DEPTH_WRITE;
+                }
+            }
+
+            if (coverage == RECT_INSIDE) {
+                stats.blocksAccepted++;
+                fillRect(setup, frameBuffer, depthTarget, blockDepthMode, x0, x1, y0, y1);
+            } else {
+                stats.blocksPartial++;
+                rasterKernel(setup, frameBuffer, depthTarget, blockDepthMode, x0, x1, y0, y1);
+            }
+            if (useDepthBuffer) {
+                depthBuffer.updateTiles(x0, x1, y0, y1);
+            }
+        }
+    }
 }
 
 
@@ -514,18 +848,103 @@ void Painter::drawLine(Vec4 &src, Vec4 &dest) {
 	Transformations, clipping, culling, rasterization are done here.
 	You may define helper functions.
 */
-void Scene::forwardRenderingPipeline(Camera *camera) {
-    auto pipe = ForwardRenderingPipeline(*this, *camera);
-    pipe.doModelingTransformations();
+void Scene::forwardRenderingPipeline(RenderContext &context, int rasterMode) {
+    auto pipe = ForwardRenderingPipeline(context, rasterMode);
     pipe.doViewingTransformations();
     pipe.doRasterization();
+}
 
+/*
+	Renders every camera into its own context and writes its image. Cameras are jobs
+	of their own, and with more than one worker each of them submits its geometry
+	batches, screen tiles and output strips as nested jobs, so a few large cameras
+	and many small ones both keep every worker busy.
+*/
+void Scene::renderCameras() {
+    jobs->resetStats();
+    if (cameras.empty()) {
+        return;
+    }
+    vector<RenderStats> cameraStats(cameras.size());
+    // the world space vertices are shared by every camera, their count goes to the first one
+    cameraStats[0].verticesModeled = doModelingTransformations();
+
+    int rasterMode = selectRasterMode();
+    auto renderCamera = [&](int i) {
+        RenderContext context(*this, *cameras[i]);
+        context.stats.merge(cameraStats[i]);
+
+        // initialize image with basic values
+        initializeImage(context);
+
+        // do forward rendering pipeline operations
+        forwardRenderingPipeline(context, rasterMode);
+
+        // generate PPM file
+        writeImageToPPMFile(context);
+
+        // Converts PPM image in given path to PNG file, by calling ImageMagick's 'convert' command.
+        // Notice that os_type is not given as 1 (Ubuntu) or 2 (Windows), below call doesn't do conversion.
+        // Change os_type to 1 or 2, after being sure that you have ImageMagick installed.
+        convertPPMToPNG(cameras[i]->outputFileName, 2);
+
+        cameraStats[i].reset();
+        cameraStats[i].merge(context.stats);
+    };
+
+    jobs->parallelFor(cameras.size(), renderCamera);
+
+    if (options.printStats) {
+        for (int i = 0; i < cameras.size(); i++) {
+            cameraStats[i].print(cout, cameras[i]->cameraId);
+        }
+        if (jobs->size() > 1) {
+            jobs->printStats(cout);
+        }
+    }
+}
+
+int Scene::selectRasterMode() const {
+    if (options.queueDepth > 0) {
+        return RASTER_PIPELINED;
+    } else if (options.frameBufferFormat == FRAMEBUFFER_PACKED && options.depthTest && jobs->size() > 1) {
+        // the order pixels are written in no longer matters, so nothing needs splitting up
+        return RASTER_SHARED;
+    } else if (options.sortLast && options.depthTest && jobs->size() > 1) {
+        // without the depth test only draw order decides, which compositing cannot restore
+        return RASTER_SORT_LAST;
+    } else if (jobs->size() > 1) {
+        return RASTER_TILED;
+    }
+    return RASTER_SERIAL;
+}
+
+/*
+	Applies command line options, starting the worker threads of the job system.
+*/
+void Scene::setOptions(const RenderOptions &options) {
+    this->options = options;
+
+    delete jobs;
+    jobs = new JobSystem(options.threadCount);
+
+    // simplified levels are only built when they can be used; wireframe meshes always show every edge
+    for (auto geometry: geometries) {
+        geometry->clearLevels();
+    }
+    if (options.lodError > 0) {
+        for (auto mesh: meshes) {
+            if (mesh->type != WIREFRAME && mesh->geometry->levels.size() == 1) {
+                mesh->geometry->buildLevels();
+            }
+        }
+    }
 }
 
 /*
 	Parses XML file
 */
-Scene::Scene(const char *xmlPath) {
+Scene::Scene(const char *xmlPath) : jobs(NULL) {
     const char *str;
     XMLDocument xmlDoc;
     XMLElement *pElement;
@@ -610,18 +1029,18 @@ Scene::Scene(const char *xmlPath) {
     int vertexId = 1;
 
     while (pVertex != NULL) {
-        Vec3 *vertex = new Vec3();
+        Vec3 vertex;
         Color *color = new Color();
 
-        vertex->colorId = vertexId;
+        vertex.colorId = vertexId;
 
         str = pVertex->Attribute("position");
-        sscanf(str, "%lf %lf %lf", &vertex->x, &vertex->y, &vertex->z);
+        sscanf(str, "%lf %lf %lf", &vertex.x, &vertex.y, &vertex.z);
 
         str = pVertex->Attribute("color");
         sscanf(str, "%lf %lf %lf", &color->r, &color->g, &color->b);
 
-        vertices.push_back(vertex);
+        vertices.addPoint(vertex.x, vertex.y, vertex.z, vertex.colorId);
         colorsOfVertices.push_back(color);
 
         pVertex = pVertex->NextSiblingElement("Vertex");
@@ -639,6 +1058,7 @@ Scene::Scene(const char *xmlPath) {
 
         str = pTranslation->Attribute("value");
         sscanf(str, "%lf %lf %lf", &translation->tx, &translation->ty, &translation->tz);
+        translation->buildMatrix();
 
         translations.push_back(translation);
 
@@ -654,6 +1074,7 @@ Scene::Scene(const char *xmlPath) {
         pScaling->QueryIntAttribute("id", &scaling->scalingId);
         str = pScaling->Attribute("value");
         sscanf(str, "%lf %lf %lf", &scaling->sx, &scaling->sy, &scaling->sz);
+        scaling->buildMatrix();
 
         scalings.push_back(scaling);
 
@@ -669,6 +1090,7 @@ Scene::Scene(const char *xmlPath) {
         pRotation->QueryIntAttribute("id", &rotation->rotationId);
         str = pRotation->Attribute("value");
         sscanf(str, "%lf %lf %lf %lf", &rotation->angle, &rotation->ux, &rotation->uy, &rotation->uz);
+        rotation->buildMatrix();
 
         rotations.push_back(rotation);
 
@@ -713,24 +1135,47 @@ Scene::Scene(const char *xmlPath) {
 
         mesh->numberOfTransformations = mesh->transformationIds.size();
 
-        // read mesh faces
-        char *row;
-        char *clone_str;
-        int v1, v2, v3;
-        XMLElement *pFaces = pMesh->FirstChildElement("Faces");
-        str = pFaces->GetText();
-        clone_str = strdup(str);
-
-        row = strtok(clone_str, "\n");
-        while (row != NULL) {
-            int result = sscanf(row, "%d %d %d", &v1, &v2, &v3);
-
-            if (result != EOF) {
-                mesh->triangles.push_back(Triangle(v1, v2, v3));
+        // an instance shares the faces of an earlier mesh instead of listing its own
+        const char *instanceOf = pMesh->Attribute("instanceOf");
+        if (instanceOf != NULL) {
+            int originalId = atoi(instanceOf);
+            for (auto original: meshes) {
+                if (original->meshId == originalId) {
+                    mesh->geometry = original->geometry;
+                }
+            }
+            if (mesh->geometry == NULL) {
+                cout << "Error: mesh " << mesh->meshId << " is an instance of unknown mesh " << instanceOf << endl;
+                exit(1);
+            }
+        } else {
+            // read mesh faces
+            char *row;
+            char *clone_str;
+            int v1, v2, v3;
+            MeshGeometry *geometry = new MeshGeometry();
+            XMLElement *pFaces = pMesh->FirstChildElement("Faces");
+            str = pFaces->GetText();
+            clone_str = strdup(str);
+
+            row = strtok(clone_str, "\n");
+            while (row != NULL) {
+                int result = sscanf(row, "%d %d %d", &v1, &v2, &v3);
+
+                if (result != EOF) {
+                    geometry->triangles.push_back(Triangle(v1, v2, v3));
+                }
+                row = strtok(NULL, "\n");
             }
-            row = strtok(NULL, "\n");
+            geometry->indexVertices(vertices);
+            geometries.push_back(geometry);
+            mesh->geometry = geometry;
+        }
+        mesh->numberOfTriangles = mesh->geometry->triangles.size();
+        // wireframe meshes are never simplified, only their full level needs edges
+        if (mesh->type == WIREFRAME && !mesh->geometry->levels[0].hasEdges()) {
+            mesh->geometry->levels[0].buildEdges();
         }
-        mesh->numberOfTriangles = mesh->triangles.size();
         meshes.push_back(mesh);
 
         pMesh = pMesh->NextSiblingElement("Mesh");
@@ -740,26 +1185,14 @@ Scene::Scene(const char *xmlPath) {
 /*
 	Initializes image with background color
 */
-void Scene::initializeImage(Camera *camera) {
-    if (this->image.empty()) {
-        for (int i = 0; i < camera->horRes; i++) {
-            vector<Color> rowOfColors;
-
-            for (int j = 0; j < camera->verRes; j++) {
-                rowOfColors.push_back(this->backgroundColor);
-            }
-
-            this->image.push_back(rowOfColors);
-        }
-    } else {
-        for (int i = 0; i < camera->horRes; i++) {
-            for (int j = 0; j < camera->verRes; j++) {
-                this->image[i][j].r = this->backgroundColor.r;
-                this->image[i][j].g = this->backgroundColor.g;
-                this->image[i][j].b = this->backgroundColor.b;
-            }
-        }
+void Scene::initializeImage(RenderContext &context) {
+    Camera *camera = &context.camera;
+    if (options.depthTest && options.frameBufferFormat != FRAMEBUFFER_PACKED) {
+        context.depthBuffer.reset(camera->horRes, camera->verRes);
     }
+
+    context.frameBuffer.reset(camera->horRes, camera->verRes, options.frameBufferFormat);
+    context.frameBuffer.clear(this->backgroundColor);
 }
 
 /*
@@ -776,9 +1209,10 @@ int Scene::makeBetweenZeroAnd255(double value) {
 }
 
 /*
-	Writes contents of image (Color**) into a PPM file.
+	Writes contents of the frame buffer into a PPM file.
 */
-void Scene::writeImageToPPMFile(Camera *camera) {
+void Scene::writeImageToPPMFile(RenderContext &context) {
+    Camera *camera = &context.camera;
     ofstream fout;
 
     fout.open(camera->outputFileName.c_str());
@@ -788,13 +1222,25 @@ void Scene::writeImageToPPMFile(Camera *camera) {
     fout << camera->horRes << " " << camera->verRes << endl;
     fout << "255" << endl;
 
-    for (int j = camera->verRes - 1; j >= 0; j--) {
-        for (int i = 0; i < camera->horRes; i++) {
-            fout << makeBetweenZeroAnd255(this->image[i][j].r) << " "
-                 << makeBetweenZeroAnd255(this->image[i][j].g) << " "
-                 << makeBetweenZeroAnd255(this->image[i][j].b) << " ";
+    // strips of rows are formatted as separate jobs and written in order
+    int stripCount = (camera->verRes + PPM_STRIP_ROWS - 1) / PPM_STRIP_ROWS;
+    vector<string> strips(stripCount);
+    jobs->parallelFor(stripCount, [&](int strip) {
+        ostringstream text;
+        int lastRow = max(camera->verRes - 1 - (strip + 1) * PPM_STRIP_ROWS, -1);
+        for (int j = camera->verRes - 1 - strip * PPM_STRIP_ROWS; j > lastRow; j--) {
+            for (int i = 0; i < camera->horRes; i++) {
+                Color color = context.frameBuffer.getPixel(i, j);
+                text << makeBetweenZeroAnd255(color.r) << " "
+                     << makeBetweenZeroAnd255(color.g) << " "
+                     << makeBetweenZeroAnd255(color.b) << " ";
+            }
+            text << "\n";
         }
-        fout << endl;
+        strips[strip] = text.str();
+    });
+    for (auto &strip: strips) {
+        fout << strip;
     }
     fout.close();
 }
@@ -5,19 +5,48 @@
 #include <cstdlib>
 #include <cstring>
 #include <iostream>
+#include <memory>
 #include <string>
 #include <vector>
 #include <limits>
 
 #include "Camera.h"
+#include "Bvh.h"
 #include "Color.h"
+#include "DepthBuffer.h"
+#include "FrameBuffer.h"
+#include "Frustum.h"
+#include "JobSystem.h"
+#include "Matrix4.h"
 #include "Mesh.h"
+#include "PipelinedRasterizer.h"
+#include "PrimitiveBatch.h"
+#include "RasterKernels.h"
+#include "RenderContext.h"
 #include "Rotation.h"
 #include "Scaling.h"
+#include "RenderOptions.h"
+#include "RenderStats.h"
+#include "SortLastRasterizer.h"
+#include "TileRasterizer.h"
 #include "Translation.h"
 #include "Triangle.h"
+#include "TriangleClipper.h"
+#include "TriangleSetup.h"
 #include "Vec3.h"
 #include "Vec4.h"
+#include "VertexStream.h"
+
+// how primitives get from the geometry stage to the frame buffer
+#define RASTER_SERIAL 0     // drawn by the calling thread as soon as they are set up
+#define RASTER_TILED 1      // binned into screen tiles, which are drawn in parallel at the end
+#define RASTER_PIPELINED 2  // queued to raster lanes that draw while the geometry is processed
+#define RASTER_SORT_LAST 3  // split among workers drawing into their own buffers, composited by depth at the end
+#define RASTER_SHARED 4     // drawn by whichever worker set them up, into one FRAMEBUFFER_PACKED buffer
+// vertices one job moves from clip space to the viewport
+#define GEOMETRY_BATCH_VERTICES 1024
+// image rows one job formats for the PPM file
+#define PPM_STRIP_ROWS 32
 
 using namespace std;
 
@@ -26,60 +55,141 @@ public:
     Color backgroundColor;
     bool cullingEnabled;
 
-    vector<vector<Color>> image;
     vector<Camera *> cameras;
-    vector<Vec3 *> vertices;
+    VertexStream vertices; // positions in object space, vertex id i is at index i - 1
     vector<Color *> colorsOfVertices;
     vector<Scaling *> scalings;
     vector<Rotation *> rotations;
     vector<Translation *> translations;
     vector<Mesh *> meshes;
+    // one per <Faces> block, instances of the same object share it
+    vector<MeshGeometry *> geometries;
+
+    // hierarchy over the world bounds of the meshes, rebuilt by doModelingTransformations
+    Bvh meshHierarchy;
+
+    RenderOptions options;
+    // shared by every stage, a single worker when running serially
+    JobSystem *jobs;
 
     Scene(const char *xmlPath);
 
-    void initializeImage(Camera *camera);
+    void setOptions(const RenderOptions &options);
+
+    long long doModelingTransformations();
+
+    void renderCameras();
+
+    // the RASTER_ mode cameras are rendered with under the current options
+    int selectRasterMode() const;
+
+    void initializeImage(RenderContext &context);
 
-    void forwardRenderingPipeline(Camera *camera);
+    // rasterMode is one of the RASTER_ modes
+    void forwardRenderingPipeline(RenderContext &context, int rasterMode);
 
     int makeBetweenZeroAnd255(double value);
 
-    void writeImageToPPMFile(Camera *camera);
+    void writeImageToPPMFile(RenderContext &context);
 
     void convertPPMToPNG(string ppmFileName, int osType);
 };
 
 class Painter {
 public:
+    RenderContext &context;
     Scene &scene;
     Camera &camera;
+    // where drawTriangle and drawLine write, the buffers of the context unless given otherwise
+    FrameBuffer &frameBuffer;
+    DepthBuffer &depthBuffer;
+    // pixels outside of [clipMinX, clipMaxX] x [clipMinY, clipMaxY] are never written
+    int clipMinX, clipMaxX, clipMinY, clipMaxY;
+    RasterKernel rasterKernel;
+    bool depthTest;
+    RenderStats stats;
 
-    Painter(Scene &scene, Camera &camera);
+    Painter(RenderContext &context);
+    Painter(RenderContext &context, FrameBuffer &frameBuffer, DepthBuffer &depthBuffer);
+
+    // adds the counters collected so far to the statistics of the context
+    void commitStats();
+
+    void setClipRect(int minX, int maxX, int minY, int maxY);
 
     void draw(int x, int y, Color color);
+    void draw(int x, int y, Color color, double depth);
 
-    void drawLine(Vec3 &src, Vec3 &dest);
-    void drawLine(Vec4 &src, Vec4 &dest);
+    void drawLine(const Vec3 &src, const Vec3 &dest, const Color &srcColor, const Color &destColor);
 
-    void drawTriangle(Triangle &triangle);
+    void drawTriangle(const TriangleSetup &setup);
 
     bool onCanvas(int x, int y) const;
 };
 
-class ForwardRenderingPipeline {
+/*
+ * Back end of the geometry stage: culls, clips and sets up triangles whose vertices
+ * are in the clip and screen space arrays of the context. Threads setting up
+ * triangles of the same mesh at the same time each have their own assembler.
+ */
+class PrimitiveAssembler {
 public:
+    RenderContext &context;
     Scene &scene;
-    Camera &camera;
-    Painter painter;
+    Painter &painter;
+    TriangleClipper clipper;
+    Matrix4 vpMatrix;
+    // collect primitives for the tiles instead of drawing them with painter
+    bool collecting;
+    PrimitiveBatch primitives;
+    RenderStats stats;
 
-    ForwardRenderingPipeline(Scene &scene, Camera &camera);
+    PrimitiveAssembler(RenderContext &context, Painter &painter, const Matrix4 &vpMatrix, bool collecting);
+
+    // handles the triangles of draw listed in context.visibleTriangles[first, last), in that order
+    void assemble(const RenderContext::MeshDraw &draw, size_t first, size_t last);
+
+    /*
+     * Back face culls the same triangles of a wireframe draw and flags the survivors in
+     * context.outlinedTriangles. Every triangle of the draw must be flagged before any is assembled.
+     */
+    void cullOutlines(const RenderContext::MeshDraw &draw, size_t first, size_t last);
+
+    // true if the outlined triangle is the one that draws its edge from corner to corner + 1
+    bool drawsEdge(const RenderContext::MeshDraw &draw, int triangle, int corner);
 
     bool isVisible(double den, double num, double& t_E, double& t_L);
 
-    bool clipping(Vec4& vertex1, Vec4& vertex2);
+    // clips the line in place, interpolating the given endpoint colors along with it
+    bool clipping(Vec4& vertex1, Vec4& vertex2, Color& color1, Color& color2);
 
-    bool isCullingExists(Triangle &triangle);
+    // hand a primitive to the painter directly or to primitives
+    void drawTriangle(const Vec3 &vertex1, const Vec3 &vertex2, const Vec3 &vertex3,
+                      const Color &color1, const Color &color2, const Color &color3);
+    void drawLine(const Vec4 &src, const Vec4 &dest, const Color &srcColor, const Color &destColor);
+
+    // clips a solid triangle given in clip space and draws what is left of it
+    void drawClippedTriangle(const Vec4 &vertex1, const Vec4 &vertex2, const Vec4 &vertex3, const Matrix4 &vpMatrix);
+
+    // true if the triangle is a back face and culling is on, or has no area and would draw nothing
+    bool isCulled(const Vec4 &vertex1, const Vec4 &vertex2, const Vec4 &vertex3, bool solid);
+};
 
-    void doModelingTransformations();
+class ForwardRenderingPipeline {
+public:
+    RenderContext &context;
+    Scene &scene;
+    Camera &camera;
+    Painter painter;
+    TileRasterizer *tileRasterizer; // null unless the mode is RASTER_TILED
+    PipelinedRasterizer *pipelinedRasterizer; // null unless the mode is RASTER_PIPELINED
+    SortLastRasterizer *sortLastRasterizer; // null unless the mode is RASTER_SORT_LAST
+    bool sharedFrameBuffer;         // RASTER_SHARED, every batch of triangles draws with one of batchPainters
+    vector<unique_ptr<Painter>> batchPainters;
+    RenderStats stats;              // geometry stage counters
+
+    ForwardRenderingPipeline(RenderContext &context, int rasterMode);
+    ~ForwardRenderingPipeline();
 
     void doViewingTransformations();
 
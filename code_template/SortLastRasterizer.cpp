@@ -0,0 +1,64 @@
+#include <algorithm>
+#include <cstring>
+#include "SortLastRasterizer.h"
+#include "JobSystem.h"
+#include "Scene.h"
+
+using namespace std;
+
+SortLastRasterizer::SortLastRasterizer(RenderContext &context, int partitionCount) : context(context) {
+    Camera &camera = context.camera;
+    painters.emplace_back(new Painter(context));
+    for (int i = 1; i < partitionCount; i++) {
+        // colors are only read where the depth says the partition drew, so they need no clearing
+        frameBuffers.emplace_back(new FrameBuffer());
+        frameBuffers.back()->reset(camera.horRes, camera.verRes, context.frameBuffer.format);
+        depthBuffers.emplace_back(new DepthBuffer());
+        depthBuffers.back()->reset(camera.horRes, camera.verRes);
+        painters.emplace_back(new Painter(context, *frameBuffers.back(), *depthBuffers.back()));
+    }
+}
+
+SortLastRasterizer::~SortLastRasterizer() {}
+
+int SortLastRasterizer::size() const {
+    return painters.size();
+}
+
+Painter &SortLastRasterizer::painter(int partition) {
+    return *painters[partition];
+}
+
+void SortLastRasterizer::composite(JobSystem &jobs) {
+    FrameBuffer &frameBuffer = context.frameBuffer;
+    DepthBuffer &depthBuffer = context.depthBuffer;
+    int width = frameBuffer.width;
+    int height = frameBuffer.height;
+    size_t pixelSize = FrameBuffer::pixelSize(frameBuffer.format);
+
+    int stripCount = (height + COMPOSITE_STRIP_ROWS - 1) / COMPOSITE_STRIP_ROWS;
+    jobs.parallelFor(stripCount, [&](int strip) {
+        int firstRow = strip * COMPOSITE_STRIP_ROWS;
+        int lastRow = min(firstRow + COMPOSITE_STRIP_ROWS, height) - 1;
+        for (int y = firstRow; y <= lastRow; y++) {
+            double *depth = depthBuffer.row(y);
+            unsigned char *color = frameBuffer.row<unsigned char>(y);
+            // partitions in order, a later one only wins where it is strictly nearer
+            for (size_t i = 0; i < depthBuffers.size(); i++) {
+                const double *partitionDepth = depthBuffers[i]->row(y);
+                const unsigned char *partitionColor = frameBuffers[i]->row<unsigned char>(y);
+                for (int x = 0; x < width; x++) {
+                    if (partitionDepth[x] < depth[x]) {
+                        depth[x] = partitionDepth[x];
+                        memcpy(color + x * pixelSize, partitionColor + x * pixelSize, pixelSize);
+                    }
+                }
+            }
+        }
+        depthBuffer.updateTiles(0, width - 1, firstRow, lastRow);
+    });
+
+    for (auto &partitionPainter: painters) {
+        partitionPainter->commitStats();
+    }
+}
@@ -0,0 +1,51 @@
+#ifndef __SORT_LAST_RASTERIZER_H__
+#define __SORT_LAST_RASTERIZER_H__
+
+#include <memory>
+#include <vector>
+#include "DepthBuffer.h"
+#include "FrameBuffer.h"
+
+// image rows one job composites, a multiple of HIZ_TILE_SIZE so jobs never share a depth tile
+#define COMPOSITE_STRIP_ROWS 32
+
+using namespace std;
+
+class JobSystem;
+class Painter;
+class RenderContext;
+
+/*
+ * Sort-last rendering. The visible triangles are split into as many contiguous runs
+ * as there are partitions and every partition draws its run with its own painter
+ * into its own color and depth buffers; composite() then keeps the nearest sample of
+ * every pixel. Equal depths go to the lower partition, whose triangles came first,
+ * which is also what the depth test keeps when drawing serially, so the result is
+ * identical. Partition 0 draws straight into the buffers of the context.
+ */
+class SortLastRasterizer
+{
+public:
+    SortLastRasterizer(RenderContext &context, int partitionCount);
+    ~SortLastRasterizer();
+
+    int size() const;
+
+    // draws into the buffers of the given partition
+    Painter &painter(int partition);
+
+    /*
+     * Merges the buffers of every partition into those of the context by depth,
+     * in strips of rows, and commits the statistics of the partition painters.
+     */
+    void composite(JobSystem &jobs);
+
+private:
+    RenderContext &context;
+    // buffers of partitions 1 and up
+    vector<unique_ptr<FrameBuffer>> frameBuffers;
+    vector<unique_ptr<DepthBuffer>> depthBuffers;
+    vector<unique_ptr<Painter>> painters;
+};
+
+#endif
@@ -0,0 +1,43 @@
+#include <algorithm>
+#include "Camera.h"
+#include "DepthBuffer.h"
+#include "TileGrid.h"
+
+using namespace std;
+
+TileGrid::TileGrid(const Camera &camera, int tileSize, bool depthTest) : tileSize(tileSize),
+                                                                         width(camera.horRes),
+                                                                         height(camera.verRes) {
+    if (depthTest && this->tileSize % HIZ_TILE_SIZE != 0) {
+        this->tileSize += HIZ_TILE_SIZE - this->tileSize % HIZ_TILE_SIZE;
+    }
+    tilesX = (width + this->tileSize - 1) / this->tileSize;
+    tilesY = (height + this->tileSize - 1) / this->tileSize;
+}
+
+void TileGrid::tileRect(int tile, int &minX, int &maxX, int &minY, int &maxY) const {
+    int tx = tile % tilesX;
+    int ty = tile / tilesX;
+    minX = tx * tileSize;
+    maxX = min((tx + 1) * tileSize, width) - 1;
+    minY = ty * tileSize;
+    maxY = min((ty + 1) * tileSize, height) - 1;
+}
+
+bool TileGrid::tilesOf(const PrimitiveBatch &batch, int primitive, int &firstX, int &lastX, int &firstY, int &lastY) const {
+    int minX, maxX, minY, maxY;
+    batch.bounds(primitive, minX, maxX, minY, maxY);
+    // same drawable area as Painter::onCanvas
+    minX = max(minX, 1);
+    maxX = min(maxX, width - 1);
+    minY = max(minY, 1);
+    maxY = min(maxY, height - 1);
+    if (minX > maxX || minY > maxY) {
+        return false;
+    }
+    firstX = minX / tileSize;
+    lastX = maxX / tileSize;
+    firstY = minY / tileSize;
+    lastY = maxY / tileSize;
+    return true;
+}
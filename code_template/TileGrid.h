@@ -0,0 +1,41 @@
+#ifndef __TILE_GRID_H__
+#define __TILE_GRID_H__
+
+#include "PrimitiveBatch.h"
+
+using namespace std;
+
+class Camera;
+
+/*
+ * The square screen tiles of a camera that the tiled and pipelined rasterizers hand
+ * to different threads. With the depth test the tile size is rounded up to a multiple
+ * of HIZ_TILE_SIZE: a coarse depth tile must not be shared by two screen tiles,
+ * their threads would race on its bounds.
+ */
+class TileGrid
+{
+public:
+    int tileSize;
+    int tilesX, tilesY;
+
+    TileGrid(const Camera &camera, int tileSize, bool depthTest);
+
+    int size() const {
+        return tilesX * tilesY;
+    }
+
+    // pixels of the tile, what a painter drawing it is clipped to
+    void tileRect(int tile, int &minX, int &maxX, int &minY, int &maxY) const;
+
+    /*
+     * Tiles [firstX, lastX] x [firstY, lastY] are the ones the primitive of batch can draw
+     * into. Returns false if it draws nothing on the canvas.
+     */
+    bool tilesOf(const PrimitiveBatch &batch, int primitive, int &firstX, int &lastX, int &firstY, int &lastY) const;
+
+private:
+    int width, height;
+};
+
+#endif
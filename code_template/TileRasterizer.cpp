@@ -0,0 +1,69 @@
+#include <algorithm>
+#include "TileRasterizer.h"
+#include "Scene.h"
+#include "JobSystem.h"
+
+using namespace std;
+
+TileRasterizer::TileRasterizer(RenderContext &context, int tileSize)
+        : context(context), grid(context.camera, tileSize, context.scene.options.depthTest) {
+    bins.resize(grid.size());
+}
+
+void TileRasterizer::bin(int primitive) {
+    int firstX, lastX, firstY, lastY;
+    if (!grid.tilesOf(primitives, primitive, firstX, lastX, firstY, lastY)) {
+        return;
+    }
+    for (int ty = firstY; ty <= lastY; ty++) {
+        for (int tx = firstX; tx <= lastX; tx++) {
+            bins[ty * grid.tilesX + tx].push_back(primitive);
+        }
+    }
+}
+
+void TileRasterizer::addTriangle(const TriangleSetup &setup) {
+    bin(primitives.addTriangle(setup));
+}
+
+void TileRasterizer::addLine(const Vec3 &src, const Vec3 &dest, const Color &srcColor, const Color &destColor) {
+    bin(primitives.addLine(src, dest, srcColor, destColor));
+}
+
+void TileRasterizer::addBatch(const PrimitiveBatch &batch) {
+    for (int primitive: batch.primitives) {
+        if (primitive % 2 == 0) {
+            addTriangle(batch.triangles[primitive / 2]);
+        } else {
+            const PrimitiveBatch::LineSetup &line = batch.lines[primitive / 2];
+            addLine(line.src, line.dest, line.srcColor, line.destColor);
+        }
+    }
+}
+
+void TileRasterizer::flush(JobSystem &jobs) {
+    jobs.parallelFor(bins.size(), [this](int tile) {
+        vector<int> &tilePrimitives = bins[tile];
+        if (tilePrimitives.empty()) {
+            return;
+        }
+
+        int minX, maxX, minY, maxY;
+        grid.tileRect(tile, minX, maxX, minY, maxY);
+        Painter painter(context);
+        painter.setClipRect(minX, maxX, minY, maxY);
+
+        for (int primitive: tilePrimitives) {
+            if (primitive % 2 == 0) {
+                painter.drawTriangle(primitives.triangles[primitive / 2]);
+            } else {
+                const PrimitiveBatch::LineSetup &line = primitives.lines[primitive / 2];
+                painter.drawLine(line.src, line.dest, line.srcColor, line.destColor);
+            }
+        }
+        tilePrimitives.clear();
+        painter.commitStats();
+    });
+
+    primitives.clear();
+}
@@ -0,0 +1,48 @@
+#ifndef __TILE_RASTERIZER_H__
+#define __TILE_RASTERIZER_H__
+
+#include <vector>
+#include "Color.h"
+#include "PrimitiveBatch.h"
+#include "TileGrid.h"
+#include "TriangleSetup.h"
+#include "Vec3.h"
+
+using namespace std;
+
+class Camera;
+class RenderContext;
+class JobSystem;
+
+/*
+ * Sort-middle rasterization. Primitives coming out of the geometry stage are
+ * recorded and binned into square screen tiles; flush() then rasterizes the
+ * tiles in parallel. Every tile is owned by exactly one thread and replays its
+ * primitives in submission order, so the result is identical to drawing them serially.
+ */
+class TileRasterizer
+{
+public:
+    TileRasterizer(RenderContext &context, int tileSize);
+
+    void addTriangle(const TriangleSetup &setup);
+    void addLine(const Vec3 &src, const Vec3 &dest, const Color &srcColor, const Color &destColor);
+    // adds every primitive of batch, in its order
+    void addBatch(const PrimitiveBatch &batch);
+
+    /*
+     * Rasterizes everything recorded so far and empties the bins.
+     */
+    void flush(JobSystem &jobs);
+
+private:
+    RenderContext &context;
+    TileGrid grid;
+    PrimitiveBatch primitives;
+    // references into primitives per tile, in submission order
+    vector<vector<int>> bins;
+
+    void bin(int primitive);
+};
+
+#endif
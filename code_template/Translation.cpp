@@ -10,6 +10,7 @@ Translation::Translation()
     this->tx = 0.0;
     this->ty = 0.0;
     this->tz = 0.0;
+    buildMatrix();
 }
 
 Translation::Translation(int translationId, double tx, double ty, double tz)
@@ -18,6 +19,18 @@ Translation::Translation(int translationId, double tx, double ty, double tz)
     this->tx = tx;
     this->ty = ty;
     this->tz = tz;
+    buildMatrix();
+}
+
+void Translation::buildMatrix()
+{
+    double translationMatrix[4][4] = {
+            {1, 0, 0, tx},
+            {0, 1, 0, ty},
+            {0, 0, 1, tz},
+            {0, 0, 0, 1}
+    };
+    matrix = Matrix4(translationMatrix);
 }
 
 ostream &operator<<(ostream &os, const Translation &t)
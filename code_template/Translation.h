@@ -2,6 +2,7 @@
 #define __TRANSLATION_H__
 
 #include <iostream>
+#include "Matrix4.h"
 
 using namespace std;
 
@@ -10,9 +11,14 @@ class Translation
 public:
     int translationId;
     double tx, ty, tz;
+    // built from the values above by buildMatrix
+    Matrix4 matrix;
 
     Translation();
     Translation(int translationId, double tx, double ty, double tz);
+
+    // fills matrix; call it again after changing tx, ty or tz
+    void buildMatrix();
     friend ostream &operator<<(ostream &os, const Translation &t);
 };
 
@@ -0,0 +1,111 @@
+#include "TriangleClipper.h"
+
+using namespace std;
+
+TriangleClipper::TriangleClipper(int horRes, int verRes) {
+    // the viewport maps [-1, 1] to the image, the guard band extends that by GUARD_BAND_PIXELS on every side
+    double guardX = 1 + 2.0 * GUARD_BAND_PIXELS / horRes;
+    double guardY = 1 + 2.0 * GUARD_BAND_PIXELS / verRes;
+    double planeTemp[CLIP_PLANE_COUNT][4] = {
+            {0,  0,  1,  1},      // near,   z >= -w
+            {0,  0,  -1, 1},      // far,    z <= w
+            {1,  0,  0,  guardX}, // left,   x >= -guardX * w
+            {-1, 0,  0,  guardX}, // right,  x <= guardX * w
+            {0,  1,  0,  guardY}, // bottom, y >= -guardY * w
+            {0,  -1, 0,  guardY}  // top,    y <= guardY * w
+    };
+    for (int i = 0; i < CLIP_PLANE_COUNT; i++) {
+        for (int j = 0; j < 4; j++) {
+            planes[i][j] = planeTemp[i][j];
+        }
+    }
+    vertexCount = 0;
+}
+
+double TriangleClipper::distance(int plane, const Vec4 &vertex) const {
+    const double *p = planes[plane];
+    return p[0] * vertex.x + p[1] * vertex.y + p[2] * vertex.z + p[3] * vertex.t;
+}
+
+/*
+ * Bit i is set when the vertex is outside face i of the view volume itself, not the guard band.
+ */
+static int outcode(const Vec4 &vertex) {
+    return (vertex.x < -vertex.t) |
+           (vertex.x > vertex.t) << 1 |
+           (vertex.y < -vertex.t) << 2 |
+           (vertex.y > vertex.t) << 3 |
+           (vertex.z < -vertex.t) << 4 |
+           (vertex.z > vertex.t) << 5;
+}
+
+int TriangleClipper::classify(const Vec4 &vertex1, const Vec4 &vertex2, const Vec4 &vertex3) const {
+    // all three vertices beyond the same face
+    if (outcode(vertex1) & outcode(vertex2) & outcode(vertex3)) {
+        return CLIP_OUTSIDE;
+    }
+
+    for (int i = 0; i < CLIP_PLANE_COUNT; i++) {
+        if (distance(i, vertex1) < 0 || distance(i, vertex2) < 0 || distance(i, vertex3) < 0) {
+            return CLIP_PARTIAL;
+        }
+    }
+    return CLIP_INSIDE;
+}
+
+int TriangleClipper::clip(const Vec4 &vertex1, const Vec4 &vertex2, const Vec4 &vertex3,
+                          const Color &color1, const Color &color2, const Color &color3) {
+    vertexCount = 3;
+    vertices[0] = vertex1;
+    vertices[1] = vertex2;
+    vertices[2] = vertex3;
+    colors[0] = color1;
+    colors[1] = color2;
+    colors[2] = color3;
+
+    for (int i = 0; i < CLIP_PLANE_COUNT && vertexCount > 0; i++) {
+        clipAgainst(i);
+    }
+    if (vertexCount < 3) {
+        vertexCount = 0;
+    }
+    return vertexCount;
+}
+
+/*
+ * One Sutherland-Hodgman pass: keeps the vertices in front of the plane and
+ * adds a new vertex wherever an edge crosses it.
+ */
+void TriangleClipper::clipAgainst(int plane) {
+    Vec4 inputVertices[MAX_CLIPPED_VERTICES];
+    Color inputColors[MAX_CLIPPED_VERTICES];
+    int inputCount = vertexCount;
+    for (int i = 0; i < inputCount; i++) {
+        inputVertices[i] = vertices[i];
+        inputColors[i] = colors[i];
+    }
+
+    vertexCount = 0;
+    for (int i = 0; i < inputCount; i++) {
+        const Vec4 &current = inputVertices[i];
+        const Vec4 &next = inputVertices[(i + 1) % inputCount];
+        double currentDistance = distance(plane, current);
+        double nextDistance = distance(plane, next);
+
+        if (currentDistance >= 0) {
+            vertices[vertexCount] = current;
+            colors[vertexCount] = inputColors[i];
+            vertexCount++;
+        }
+        if ((currentDistance >= 0) != (nextDistance >= 0)) {
+            double t = currentDistance / (currentDistance - nextDistance);
+            vertices[vertexCount] = Vec4(current.x + t * (next.x - current.x),
+                                         current.y + t * (next.y - current.y),
+                                         current.z + t * (next.z - current.z),
+                                         current.t + t * (next.t - current.t),
+                                         current.colorId);
+            colors[vertexCount] = inputColors[i].interpolate(inputColors[(i + 1) % inputCount], t);
+            vertexCount++;
+        }
+    }
+}
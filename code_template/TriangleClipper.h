@@ -0,0 +1,59 @@
+#ifndef __TRIANGLE_CLIPPER_H__
+#define __TRIANGLE_CLIPPER_H__
+
+#include "Color.h"
+#include "Vec4.h"
+
+#define CLIP_OUTSIDE 0
+#define CLIP_INSIDE 1
+#define CLIP_PARTIAL 2
+
+#define CLIP_PLANE_COUNT 6
+// every plane can add at most one vertex to the polygon
+#define MAX_CLIPPED_VERTICES (3 + CLIP_PLANE_COUNT)
+
+// how far past each side of the viewport, in pixels, vertices may go before x and y are clipped
+#define GUARD_BAND_PIXELS 8192
+
+/*
+ * Clips solid triangles in homogeneous clip space, before the perspective divide.
+ *
+ * Near and far are clipped exactly, so no vertex ever reaches w <= 0. x and y
+ * are only clipped against a guard band much larger than the image: triangles
+ * crossing the image borders are left whole and the rasterizer clamps their
+ * bounding box to the viewport, which is cheaper than splitting them. The guard
+ * band keeps screen coordinates inside the range TriangleSetup can handle.
+ */
+class TriangleClipper
+{
+public:
+    // plane i keeps the points where planes[i] . (x, y, z, w) >= 0
+    double planes[CLIP_PLANE_COUNT][4];
+
+    // result of the last clip()
+    int vertexCount;
+    Vec4 vertices[MAX_CLIPPED_VERTICES];
+    Color colors[MAX_CLIPPED_VERTICES];
+
+    TriangleClipper(int horRes, int verRes);
+
+    /*
+     * Returns CLIP_OUTSIDE if the triangle is entirely outside the view volume,
+     * CLIP_INSIDE if it does not cross any clip plane and CLIP_PARTIAL otherwise.
+     */
+    int classify(const Vec4 &vertex1, const Vec4 &vertex2, const Vec4 &vertex3) const;
+
+    /*
+     * Clips the triangle against every plane, leaving a convex polygon in vertices
+     * and colors. Colors are interpolated along with the positions.
+     * Returns the vertex count, which is 0 or at least 3.
+     */
+    int clip(const Vec4 &vertex1, const Vec4 &vertex2, const Vec4 &vertex3,
+             const Color &color1, const Color &color2, const Color &color3);
+
+private:
+    double distance(int plane, const Vec4 &vertex) const;
+    void clipAgainst(int plane);
+};
+
+#endif
@@ -0,0 +1,117 @@
+#include <algorithm>
+#include <cmath>
+#include "TriangleSetup.h"
+
+using namespace std;
+
+TriangleSetup::TriangleSetup() {
+    for (int i = 0; i < 3; i++) {
+        a[i] = b[i] = c[i] = 0;
+        threshold[i] = 0;
+    }
+    doubleArea = 0;
+    invDoubleArea = 0;
+    minX = maxX = minY = maxY = 0;
+}
+
+static long long floorDiv(long long value, long long divisor) {
+    return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor);
+}
+
+static long long ceilDiv(long long value, long long divisor) {
+    return -floorDiv(-value, divisor);
+}
+
+bool TriangleSetup::setup(const Vec3 &vertex1, const Vec3 &vertex2, const Vec3 &vertex3,
+                          const Color &color1, const Color &color2, const Color &color3,
+                          int clipMinX, int clipMaxX, int clipMinY, int clipMaxY) {
+    const Vec3 *vertices[3] = {&vertex1, &vertex2, &vertex3};
+    long long x[3], y[3];
+    for (int i = 0; i < 3; i++) {
+        // also false for NaN
+        if (!(fabs(vertices[i]->x) < MAX_VERTEX_COORDINATE && fabs(vertices[i]->y) < MAX_VERTEX_COORDINATE)) {
+            return false;
+        }
+        x[i] = llround(vertices[i]->x * SUBPIXEL_SCALE);
+        y[i] = llround(vertices[i]->y * SUBPIXEL_SCALE);
+    }
+
+    // a and b are scaled by SUBPIXEL_SCALE so a pixel step is a whole number of subpixels
+    for (int i = 0; i < 3; i++) {
+        int j = (i + 1) % 3;
+        int k = (i + 2) % 3;
+        a[i] = (y[j] - y[k]) * SUBPIXEL_SCALE;
+        b[i] = (x[k] - x[j]) * SUBPIXEL_SCALE;
+        c[i] = x[j] * y[k] - x[k] * y[j];
+    }
+
+    doubleArea = (a[0] * x[0] + b[0] * y[0]) / SUBPIXEL_SCALE + c[0];
+    if (doubleArea == 0) {
+        return false;
+    }
+    if (doubleArea < 0) {
+        doubleArea = -doubleArea;
+        for (int i = 0; i < 3; i++) {
+            a[i] = -a[i];
+            b[i] = -b[i];
+            c[i] = -c[i];
+        }
+    }
+    invDoubleArea = 1.0 / (double) doubleArea;
+
+    // top-left rule: the gradient (a, b) points inside, a left edge has the inside
+    // to its right (+x) and a top edge is horizontal with the inside below it (-y)
+    for (int i = 0; i < 3; i++) {
+        bool topLeft = a[i] > 0 || (a[i] == 0 && b[i] < 0);
+        threshold[i] = topLeft ? 0 : 1;
+    }
+
+    // pixels whose centers fall inside the bounding box of the snapped vertices
+    minX = max((long long) clipMinX, ceilDiv(min(x[0], min(x[1], x[2])), SUBPIXEL_SCALE));
+    maxX = min((long long) clipMaxX, floorDiv(max(x[0], max(x[1], x[2])), SUBPIXEL_SCALE));
+    minY = max((long long) clipMinY, ceilDiv(min(y[0], min(y[1], y[2])), SUBPIXEL_SCALE));
+    maxY = min((long long) clipMaxY, floorDiv(max(y[0], max(y[1], y[2])), SUBPIXEL_SCALE));
+
+    c0 = color1;
+    c1 = color2;
+    c2 = color3;
+
+    z0 = vertex1.z;
+    z1 = vertex2.z;
+    z2 = vertex3.z;
+    zA = (a[0] * z0 + a[1] * z1 + a[2] * z2) * invDoubleArea;
+    zB = (b[0] * z0 + b[1] * z1 + b[2] * z2) * invDoubleArea;
+    zC = (c[0] * z0 + c[1] * z1 + c[2] * z2) * invDoubleArea;
+    minZ = min(z0, min(z1, z2));
+    maxZ = max(z0, max(z1, z2));
+
+    return minX <= maxX && minY <= maxY;
+}
+
+int TriangleSetup::classifyRect(int x0, int x1, int y0, int y1) const {
+    bool allInside = true;
+    for (int i = 0; i < 3; i++) {
+        long long ax0 = a[i] * x0, ax1 = a[i] * x1;
+        long long by0 = b[i] * y0, by1 = b[i] * y1;
+        // an edge function is linear, so its extremes over the rectangle are at the corners
+        if (c[i] + max(ax0, ax1) + max(by0, by1) < threshold[i]) {
+            return RECT_OUTSIDE;
+        }
+        if (c[i] + min(ax0, ax1) + min(by0, by1) < threshold[i]) {
+            allInside = false;
+        }
+    }
+    return allInside ? RECT_INSIDE : RECT_PARTIAL;
+}
+
+void TriangleSetup::depthRange(int x0, int x1, int y0, int y1, double &nearest, double &farthest) const {
+    // the plane takes its extremes over the rectangle at the corners
+    double zx0 = zA * x0, zx1 = zA * x1;
+    double zy0 = zB * y0, zy1 = zB * y1;
+    nearest = max(zC + min(zx0, zx1) + min(zy0, zy1), minZ);
+    farthest = min(zC + max(zx0, zx1) + max(zy0, zy1), maxZ);
+
+    double slack = 1e-7 * (1 + fabs(nearest) + fabs(farthest));
+    nearest -= slack;
+    farthest += slack;
+}
@@ -0,0 +1,89 @@
+#ifndef __TRIANGLE_SETUP_H__
+#define __TRIANGLE_SETUP_H__
+
+#include "Vec3.h"
+#include "Color.h"
+
+#define RECT_OUTSIDE 0
+#define RECT_INSIDE 1
+#define RECT_PARTIAL 2
+
+// vertex positions are snapped to 24.8 fixed point
+#define SUBPIXEL_BITS 8
+#define SUBPIXEL_SCALE (1 << SUBPIXEL_BITS)
+// vertices must stay within this many pixels of the origin, which keeps every
+// edge value below 2^53 so it is exact in a double as well
+#define MAX_VERTEX_COORDINATE 65536
+
+/*
+ * Per triangle rasterization state. Pixel (x, y) is sampled at its center,
+ * which the viewport transformation puts at integer coordinates. Edge functions
+ * are evaluated as e(x, y) = a * x + b * y + c in exact integer math with
+ * 2 * SUBPIXEL_BITS fractional bits, so they can be stepped incrementally:
+ * moving one pixel in x adds a, moving one pixel in y adds b.
+ *
+ * edge[0] is the edge opposite to vertex1, edge[1] is opposite to vertex2 and
+ * edge[2] is opposite to vertex3. The edges are oriented so that the inside of
+ * the triangle is positive whatever the winding.
+ *
+ * Pixels exactly on an edge belong to the triangle only for top and left edges,
+ * so a pixel on an edge shared by two triangles is drawn once.
+ */
+class TriangleSetup
+{
+public:
+    long long a[3], b[3], c[3];
+    // smallest inside value of each edge: 0 for top-left edges, 1 for the others
+    long long threshold[3];
+    long long doubleArea; // value of every edge function at its opposite vertex, always positive
+    double invDoubleArea;
+    int minX, maxX, minY, maxY;
+    Color c0, c1, c2;
+    double z0, z1, z2;
+    // depth as a plane over the screen, z(x, y) = zA * x + zB * y + zC
+    double zA, zB, zC;
+    double minZ, maxZ;
+
+    TriangleSetup();
+
+    /*
+     * Computes edge coefficients, reciprocal area and the bounding box clipped
+     * to [clipMinX, clipMaxX] x [clipMinY, clipMaxY].
+     * Returns false if the triangle is degenerate, covers no pixel of the clip rectangle
+     * or has a vertex beyond MAX_VERTEX_COORDINATE.
+     */
+    bool setup(const Vec3 &vertex1, const Vec3 &vertex2, const Vec3 &vertex3,
+               const Color &color1, const Color &color2, const Color &color3,
+               int clipMinX, int clipMaxX, int clipMinY, int clipMaxY);
+
+    long long edgeAt(int edge, int x, int y) const {
+        return a[edge] * x + b[edge] * y + c[edge];
+    }
+
+    bool inside(long long e0, long long e1, long long e2) const {
+        return e0 >= threshold[0] && e1 >= threshold[1] && e2 >= threshold[2];
+    }
+
+    /*
+     * Classifies the pixels of [x0, x1] x [y0, y1] by testing the rectangle corners
+     * against every edge: RECT_OUTSIDE if none of them is covered, RECT_INSIDE if all
+     * of them are, RECT_PARTIAL otherwise.
+     */
+    int classifyRect(int x0, int x1, int y0, int y1) const;
+
+    /*
+     * Bounds of the depth of the covered pixels of [x0, x1] x [y0, y1], loosened
+     * a little so rounding in depthAt can never fall outside of them.
+     */
+    void depthRange(int x0, int x1, int y0, int y1, double &nearest, double &farthest) const;
+
+    Color colorAt(long long e0, long long e1, long long e2) const {
+        return c0.interpolate(c1, c2, e0 * invDoubleArea, e1 * invDoubleArea, e2 * invDoubleArea);
+    }
+
+    double depthAt(long long e0, long long e1, long long e2) const {
+        return e0 * invDoubleArea * z0 + e1 * invDoubleArea * z1 + e2 * invDoubleArea * z2;
+    }
+};
+
+#endif
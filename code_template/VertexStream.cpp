@@ -0,0 +1,94 @@
+#include "VertexStream.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAS_X86_KERNELS 1
+#endif
+
+using namespace std;
+
+void VertexStream::clear() {
+    x.clear();
+    y.clear();
+    z.clear();
+    w.clear();
+    colorIds.clear();
+}
+
+void VertexStream::resize(size_t count, bool homogeneous) {
+    x.resize(count);
+    y.resize(count);
+    z.resize(count);
+    w.resize(homogeneous ? count : 0);
+    colorIds.resize(count);
+}
+
+void VertexStream::addPoint(double x, double y, double z, int colorId) {
+    this->x.push_back(x);
+    this->y.push_back(y);
+    this->z.push_back(z);
+    this->colorIds.push_back(colorId);
+}
+
+/*
+ * Rows are accumulated from zero in column order, without FMA, like multiplyMatrixWithVec4.
+ */
+static void transformPointsScalar(const Matrix4 &m, const VertexStream &points, VertexStream &result,
+                                  size_t first, size_t last) {
+    double *out[4] = {result.x.data(), result.y.data(), result.z.data(), result.w.data()};
+    for (size_t i = first; i < last; i++) {
+        for (int row = 0; row < 4; row++) {
+            double total = 0;
+            total += m.val[row][0] * points.x[i];
+            total += m.val[row][1] * points.y[i];
+            total += m.val[row][2] * points.z[i];
+            total += m.val[row][3];
+            out[row][i] = total;
+        }
+    }
+}
+
+#ifdef HAS_X86_KERNELS
+
+__attribute__((target("avx")))
+static size_t transformPointsAvx(const Matrix4 &m, const VertexStream &points, VertexStream &result) {
+    double *out[4] = {result.x.data(), result.y.data(), result.z.data(), result.w.data()};
+    __m256d column[4][4];
+    for (int row = 0; row < 4; row++) {
+        for (int col = 0; col < 4; col++) {
+            column[row][col] = _mm256_set1_pd(m.val[row][col]);
+        }
+    }
+
+    size_t count = points.size() / 4 * 4;
+    for (size_t i = 0; i < count; i += 4) {
+        __m256d x = _mm256_loadu_pd(&points.x[i]);
+        __m256d y = _mm256_loadu_pd(&points.y[i]);
+        __m256d z = _mm256_loadu_pd(&points.z[i]);
+        for (int row = 0; row < 4; row++) {
+            __m256d total = _mm256_add_pd(_mm256_setzero_pd(), _mm256_mul_pd(column[row][0], x));
+            total = _mm256_add_pd(total, _mm256_mul_pd(column[row][1], y));
+            total = _mm256_add_pd(total, _mm256_mul_pd(column[row][2], z));
+            total = _mm256_add_pd(total, column[row][3]);
+            _mm256_storeu_pd(out[row] + i, total);
+        }
+    }
+    return count;
+}
+
+#endif
+
+void transformPoints(const Matrix4 &m, const VertexStream &points, VertexStream &result) {
+    size_t count = points.size();
+    result.resize(count, true);
+    result.colorIds = points.colorIds;
+
+    size_t done = 0;
+#ifdef HAS_X86_KERNELS
+    if (__builtin_cpu_supports("avx")) {
+        done = transformPointsAvx(m, points, result);
+    }
+#endif
+    // the remainder of the last batch, or everything without AVX
+    transformPointsScalar(m, points, result, done, count);
+}
@@ -0,0 +1,42 @@
+#ifndef __VERTEX_STREAM_H__
+#define __VERTEX_STREAM_H__
+
+#include <vector>
+#include "Matrix4.h"
+#include "Vec4.h"
+
+using namespace std;
+
+/*
+ * Vertices stored as a structure of arrays, so a batch of consecutive vertices
+ * can be loaded straight into SIMD registers. Points have no w array, their w
+ * is implicitly 1; the results of transformPoints are homogeneous.
+ */
+class VertexStream
+{
+public:
+    vector<double> x, y, z, w;
+    vector<int> colorIds;
+
+    size_t size() const {
+        return x.size();
+    }
+
+    void clear();
+    void resize(size_t count, bool homogeneous);
+
+    void addPoint(double x, double y, double z, int colorId);
+
+    Vec4 getVec4(size_t i) const {
+        return Vec4(x[i], y[i], z[i], w.empty() ? 1 : w[i], colorIds[i]);
+    }
+};
+
+/*
+ * Multiplies every point of points by m, writing homogeneous results to result.
+ * The w of points is taken as 1, which holds for the results of affine transformations.
+ * Uses AVX when the CPU supports it; both paths round exactly like multiplyMatrixWithVec4.
+ */
+void transformPoints(const Matrix4 &m, const VertexStream &points, VertexStream &result);
+
+#endif